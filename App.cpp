@@ -63,6 +63,7 @@ void App::Initialize()
 	mPlanetModel->SetRotation(XMFLOAT3{ 0, 0, 0 }, false);
 	mPlanetModel->SetScale(XMFLOAT3{ float(mPlanet->mScale), float(mPlanet->mScale), float(mPlanet->mScale) }, true);
 	mPlanetModel->mParallax = false;
+	mPlanetModel->mBoundingRadius = 1 + PlanetSurface::MAX_ELEVATION;
 	mModels.push_back(mPlanetModel);
 
 	LoadModels();
@@ -236,8 +237,8 @@ void App::BuildFrameResources()
 {
 	for (int i = 0; i < mGraphics->mNumFrameResources; i++)
 	{
-		// Create a frame resource with the number of models, max base planet vertices and indices, and the number of materials 
-		FrameResources.push_back(std::make_unique<FrameResource>(D3DDevice.Get(), 1, mModels.size(), MAX_PLANET_VERTS, MAX_PLANET_VERTS * 3, mMaterials.size())); //1 for planet
+		// Create a frame resource with the number of models and the number of materials, planet buffers grow as needed
+		FrameResources.push_back(std::make_unique<FrameResource>(D3DDevice.Get(), 1, mModels.size(), mMaterials.size())); //1 for planet
 	}
 }
 
@@ -249,6 +250,13 @@ void App::RecreatePlanetGeometry()
 	// Set the planet model's mesh to the new planet mesh and flag as dirty
 	mModels[0]->mConstructorMesh = mPlanet->mMesh;
 	mModels[0]->mNumDirtyFrames += mGraphics->mNumFrameResources;
+
+	// Every frame resource needs the whole new planet
+	for (auto& frameResource : FrameResources)
+	{
+		frameResource->mPlanetVB->MarkAllDirty();
+		frameResource->mPlanetIB->MarkAllDirty();
+	}
 }
 
 
@@ -309,22 +317,22 @@ void App::CreateSkybox()
 
 void App::UpdatePlanetBuffers()
 {
-	if (mModels[0]->mNumDirtyFrames > 0)
+	auto frameResource = mGraphics->mCurrentFrameResource;
+	auto mesh = mPlanet->mMesh;
+
+	// Fit the buffers to the planet, then copy the ranges changed since this frame resource was last
+	// used straight from the planet's geometry
+	frameResource->ReservePlanetVertices(D3DDevice.Get(), UINT(mPlanet->GetVertices().size()));
+	frameResource->mPlanetVB->Flush(mPlanet->GetVertices());
+	frameResource->mPlanetIB->Flush(mPlanet->GetIndices());
+
+	// Draw from this frame resource's buffers, the others may still be in use by the GPU
+	mesh->mGPUVertexBuffer = frameResource->mPlanetVB->GetBuffer();
+	mesh->mIndexPages.clear();
+	for (size_t page = 0; page < frameResource->mPlanetIB->NumPages(); page++)
 	{
-		// Copy geometry into dynamic vertex and index buffers
-		for (int i = 0; i < mPlanet->mMesh->mVertices.size(); i++)
-		{
-			mGraphics->mCurrentFrameResource->mPlanetVB->Copy(i, mPlanet->mMesh->mVertices[i]);
-		}
-		for (int i = 0; i < mPlanet->mMesh->mIndices.size(); i++)
-		{
-			mGraphics->mCurrentFrameResource->mPlanetIB->Copy(i, mPlanet->mMesh->mIndices[i]);
-		}
-
-		// Set the planet mesh's buffers 
-		mModels[0]->mConstructorMesh->mGPUVertexBuffer = mGraphics->mCurrentFrameResource->mPlanetVB->GetBuffer();
-		mModels[0]->mConstructorMesh->mGPUIndexBuffer = mGraphics->mCurrentFrameResource->mPlanetIB->GetBuffer();
-		// NumDirtyFrames reduced by UpdatePerObject
+		auto buffer = frameResource->mPlanetIB->GetPage(page)->GetBuffer();
+		mesh->mIndexPages.push_back({ buffer->GetGPUVirtualAddress(), frameResource->mPlanetIB->PageCount(page) });
 	}
 }
 
@@ -360,13 +368,30 @@ void App::Update(float frameTime)
 		MessageBox(0, L"Command List reset failed", L"Error", MB_OK);
 	}
 
+	// Release mesh staging buffers the GPU has copied from
+	MeshBufferHeap->Collect(mGraphics->mFence->GetCompletedValue());
+
 	// Update planet
+	mPlanet->mMaxPixelError = mGUI->mPixelError;
+	mPlanet->mLodBudget = mGUI->mLodBudget;
+	mPlanet->mMemoryBudget = size_t(mGUI->mMemoryBudget) << 20;
+	mPlanet->mFrameResourceBytes = 0;
+	for (auto& frameResource : FrameResources) mPlanet->mFrameResourceBytes += frameResource->GetPlanetBufferBytes();
 	if (mPlanet->Update(mCamera.get(), commandList))
 	{
 		// If planet geometry was updated set new mesh
-		mModels[0]->mNumDirtyFrames += mGraphics->mNumFrameResources;
 		mModels[0]->mConstructorMesh = mPlanet->mMesh;
 
+		// Queue the changed ranges for every frame resource to copy when it is next used
+		DirtyIntervals vertices, indices;
+		for (auto& range : mPlanet->mDirtyVertexRanges) vertices.Add(range.Offset / sizeof(Vertex), range.Size / sizeof(Vertex));
+		for (auto& range : mPlanet->mDirtyIndexRanges) indices.Add(range.Offset / sizeof(uint32_t), range.Size / sizeof(uint32_t));
+		for (auto& frameResource : FrameResources)
+		{
+			frameResource->mPlanetVB->MarkDirty(vertices);
+			frameResource->mPlanetIB->MarkDirty(indices);
+		}
+
 		// Execute commands on command list
 		mGraphics->CloseAndExecuteCommandList();
 
@@ -552,8 +577,8 @@ void App::Draw(float frameTime)
 	cubeTex.Offset(mSkyMat->DiffuseSRVIndex, CbvSrvUavDescriptorSize);
 	commandList->SetGraphicsRootDescriptorTable(4, cubeTex);
 	
-	// Draw models
-	//DrawModels(commandList);
+	// Draw models, those behind the planet are culled
+	if (mGUI->mDrawModels) DrawModels(commandList);
 
 	// Draw base planet geometry
 	DrawPlanet(commandList);
@@ -563,14 +588,14 @@ void App::Draw(float frameTime)
 
 	// Thread planet chunk rendering
 	int start = 0;
-	int count = (mPlanet->mTriangleChunks.size() + mNumRenderWorkers - 1) / mNumRenderWorkers;
+	int count = (mPlanet->mVisibleChunks.size() + mNumRenderWorkers - 1) / mNumRenderWorkers;
 	for (int i = 0; i < mNumRenderWorkers; ++i)
 	{
 		// Prepare work
 		auto& work = mRenderWorkers[i].second;
 		work.start = start;
 		start += count;
-		if (start > mPlanet->mTriangleChunks.size())  start = mPlanet->mTriangleChunks.size();
+		if (start > mPlanet->mVisibleChunks.size())  start = mPlanet->mVisibleChunks.size();
 		work.end = start;
 
 		// Flag the work as not yet complete
@@ -655,7 +680,7 @@ void App::DrawModels(ID3D12GraphicsCommandList* commandList)
 
 	for(int i = 0; i < mColourModels.size(); i++)
 	{		
-		mColourModels[i]->Draw(commandList);
+		if (!IsModelBelowHorizon(mColourModels[i])) mColourModels[i]->Draw(commandList);
 	}
 
 	if (mWireframe) { commandList->SetPipelineState(mGraphics->mWireframePSO.Get()); }
@@ -663,7 +688,7 @@ void App::DrawModels(ID3D12GraphicsCommandList* commandList)
 
 	for(int i = 0; i < mTexModels.size(); i++)
 	{
-		mTexModels[i]->Draw(commandList);
+		if (!IsModelBelowHorizon(mTexModels[i])) mTexModels[i]->Draw(commandList);
 	}
 
 	if (mWireframe) { commandList->SetPipelineState(mGraphics->mWireframePSO.Get()); }
@@ -671,10 +696,16 @@ void App::DrawModels(ID3D12GraphicsCommandList* commandList)
 
 	for (int i = 0; i < mSimpleTexModels.size(); i++)
 	{
-		mSimpleTexModels[i]->Draw(commandList);
+		if (!IsModelBelowHorizon(mSimpleTexModels[i])) mSimpleTexModels[i]->Draw(commandList);
 	}
 }
 
+bool App::IsModelBelowHorizon(Model* model)
+{
+	// Bound the model by a sphere around its position
+	return mPlanet->IsBelowHorizon(mCamera->mPos, model->mPosition, model->GetBoundingRadius());
+}
+
 void App::RenderThread(int thread)
 {
 	auto& worker = mRenderWorkers[thread].first;
@@ -718,13 +749,13 @@ void App::RenderChunks(int thread, int start, int end)
 
 	mGraphics->SetMSAARenderTarget(commandList);
 
-	// Set pipeline state to render planet
-	if(mWireframe) commandList->SetPipelineState(mGraphics->mWireframePSO.Get());
-	else commandList->SetPipelineState(mGraphics->mPlanetPSO.Get());
+	// Set pipeline state to render chunks, which use the compact planet vertex
+	if(mWireframe) commandList->SetPipelineState(mGraphics->mChunkWireframePSO.Get());
+	else commandList->SetPipelineState(mGraphics->mChunkPSO.Get());
 
 	// Render section of chunks
 	for (int i = start; i < end; ++i)
-		mPlanet->mTriangleChunks[i]->mMesh->Draw(commandList);
+		mPlanet->mVisibleChunks[i]->mMesh->Draw(commandList);
 
 	// Execute commands
 	mGraphics->CloseAndExecuteCommandList(thread, 0);
@@ -738,6 +769,9 @@ void App::EndFrame()
 	// Set a new fence point when reached by GPU
 	CommandQueue->Signal(mGraphics->mFence.Get(), mGraphics->mCurrentFence);
 
+	// Staging buffers for meshes uploaded this frame are finished with at the same point
+	MeshBufferHeap->EndFrame(mGraphics->mCurrentFence);
+
 	// Cycle through frame resources
 	mGraphics->CycleFrameResources();
 }
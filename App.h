@@ -128,6 +128,9 @@ private:
 
 	void LoadModels();
 	void UpdateSelectedModel();
+
+	// Is a model hidden behind the planet's horizon
+	bool IsModelBelowHorizon(Model* model);
 	void UpdatePerObjectConstantBuffers();
 	void UpdatePerFrameConstantBuffer();
 	void UpdatePerMaterialConstantBuffers();
@@ -0,0 +1,216 @@
+#include "BlockAllocator.h"
+#include <bit>
+
+BlockAllocator::BlockAllocator(std::uint64_t capacity) : mCapacity(capacity)
+{
+	for (auto& lists : mFreeLists)
+	{
+		for (auto& list : lists) list = INVALID_BLOCK;
+	}
+
+	// Start with one free block covering everything
+	auto block = NewBlock();
+	mBlocks[block].Offset = 0;
+	mBlocks[block].Size = capacity;
+	InsertFree(block);
+}
+
+bool BlockAllocator::Allocate(std::uint64_t size, std::uint64_t alignment, Allocation& allocation)
+{
+	if (size == 0) return false;
+	if (alignment < MIN_BLOCK_SIZE) alignment = MIN_BLOCK_SIZE;
+	size = (size + MIN_BLOCK_SIZE - 1) & ~(MIN_BLOCK_SIZE - 1);
+
+	// Ask for enough extra to align any free block's start
+	auto block = FindFreeBlock(size + alignment - MIN_BLOCK_SIZE);
+	if (block == INVALID_BLOCK) return false;
+	RemoveFree(block);
+
+	// Leave the space before the aligned offset free
+	auto padding = ((mBlocks[block].Offset + alignment - 1) & ~(alignment - 1)) - mBlocks[block].Offset;
+	if (padding > 0)
+	{
+		SplitTail(block, mBlocks[block].Size - padding);
+		auto front = block;
+		block = mBlocks[front].Next;
+		RemoveFree(block);
+		InsertFree(front);
+	}
+
+	// Give back what is left after the allocation
+	if (mBlocks[block].Size - size >= MIN_BLOCK_SIZE) SplitTail(block, mBlocks[block].Size - size);
+
+	mBlocks[block].Free = false;
+	mUsedBytes += mBlocks[block].Size;
+	mNumAllocations++;
+
+	allocation.Offset = mBlocks[block].Offset;
+	allocation.Size = mBlocks[block].Size;
+	allocation.Block = block;
+	return true;
+}
+
+void BlockAllocator::Free(Allocation& allocation)
+{
+	if (!allocation.IsValid()) return;
+	auto block = allocation.Block;
+	allocation = Allocation();
+
+	mUsedBytes -= mBlocks[block].Size;
+	mNumAllocations--;
+	mBlocks[block].Free = true;
+
+	// Merge with free neighbours
+	auto next = mBlocks[block].Next;
+	if (next != INVALID_BLOCK && mBlocks[next].Free)
+	{
+		RemoveFree(next);
+		MergeIntoPrevious(next);
+	}
+	auto previous = mBlocks[block].Previous;
+	if (previous != INVALID_BLOCK && mBlocks[previous].Free)
+	{
+		RemoveFree(previous);
+		MergeIntoPrevious(block);
+		block = previous;
+	}
+	InsertFree(block);
+}
+
+BlockAllocator::Stats BlockAllocator::GetStats() const
+{
+	Stats stats;
+	stats.Capacity = mCapacity;
+	stats.UsedBytes = mUsedBytes;
+	stats.FreeBytes = mCapacity - mUsedBytes;
+	stats.NumAllocations = mNumAllocations;
+
+	for (int firstLevel = 0; firstLevel < NUM_FIRST_LEVELS; firstLevel++)
+	{
+		for (int secondLevel = 0; secondLevel < NUM_SECOND_LEVELS; secondLevel++)
+		{
+			for (auto block = mFreeLists[firstLevel][secondLevel]; block != INVALID_BLOCK; block = mBlocks[block].NextFree)
+			{
+				stats.NumFreeBlocks++;
+				if (mBlocks[block].Size > stats.LargestFreeBlock) stats.LargestFreeBlock = mBlocks[block].Size;
+			}
+		}
+	}
+	return stats;
+}
+
+void BlockAllocator::MapSize(std::uint64_t size, int& firstLevel, int& secondLevel)
+{
+	// Sizes below one linear step of the smallest level share level zero
+	if (size < NUM_SECOND_LEVELS)
+	{
+		firstLevel = 0;
+		secondLevel = int(size);
+		return;
+	}
+	firstLevel = int(std::bit_width(size)) - 1;
+	secondLevel = int(size >> (firstLevel - SECOND_LEVEL_BITS)) - NUM_SECOND_LEVELS;
+}
+
+std::uint32_t BlockAllocator::FindFreeBlock(std::uint64_t size)
+{
+	// Round up to the next list so any block found is large enough
+	if (size >= NUM_SECOND_LEVELS)
+	{
+		auto step = std::uint64_t(1) << (int(std::bit_width(size)) - 1 - SECOND_LEVEL_BITS);
+		size += step - 1;
+	}
+	int firstLevel, secondLevel;
+	MapSize(size, firstLevel, secondLevel);
+	if (firstLevel >= NUM_FIRST_LEVELS) return INVALID_BLOCK;
+
+	// Look in this first level from the second level up, then in the next first level with anything free
+	auto secondLevelMask = mSecondLevelMasks[firstLevel] & (~0u << secondLevel);
+	if (!secondLevelMask)
+	{
+		auto firstLevelMask = firstLevel + 1 < NUM_FIRST_LEVELS ? mFirstLevelMask & (~std::uint64_t(0) << (firstLevel + 1)) : 0;
+		if (!firstLevelMask) return INVALID_BLOCK;
+		firstLevel = std::countr_zero(firstLevelMask);
+		secondLevelMask = mSecondLevelMasks[firstLevel];
+	}
+	return mFreeLists[firstLevel][std::countr_zero(secondLevelMask)];
+}
+
+void BlockAllocator::InsertFree(std::uint32_t block)
+{
+	int firstLevel, secondLevel;
+	MapSize(mBlocks[block].Size, firstLevel, secondLevel);
+
+	auto& head = mFreeLists[firstLevel][secondLevel];
+	mBlocks[block].Free = true;
+	mBlocks[block].PreviousFree = INVALID_BLOCK;
+	mBlocks[block].NextFree = head;
+	if (head != INVALID_BLOCK) mBlocks[head].PreviousFree = block;
+	head = block;
+
+	mFirstLevelMask |= std::uint64_t(1) << firstLevel;
+	mSecondLevelMasks[firstLevel] |= 1u << secondLevel;
+}
+
+void BlockAllocator::RemoveFree(std::uint32_t block)
+{
+	int firstLevel, secondLevel;
+	MapSize(mBlocks[block].Size, firstLevel, secondLevel);
+
+	auto previous = mBlocks[block].PreviousFree;
+	auto next = mBlocks[block].NextFree;
+	if (previous != INVALID_BLOCK) mBlocks[previous].NextFree = next;
+	else mFreeLists[firstLevel][secondLevel] = next;
+	if (next != INVALID_BLOCK) mBlocks[next].PreviousFree = previous;
+
+	// Clear the level bits once the list is empty
+	if (mFreeLists[firstLevel][secondLevel] == INVALID_BLOCK)
+	{
+		mSecondLevelMasks[firstLevel] &= ~(1u << secondLevel);
+		if (!mSecondLevelMasks[firstLevel]) mFirstLevelMask &= ~(std::uint64_t(1) << firstLevel);
+	}
+	mBlocks[block].Free = false;
+}
+
+void BlockAllocator::SplitTail(std::uint32_t block, std::uint64_t size)
+{
+	auto tail = NewBlock();
+	auto& original = mBlocks[block];
+	auto& split = mBlocks[tail];
+
+	split.Offset = original.Offset + original.Size - size;
+	split.Size = size;
+	original.Size -= size;
+
+	// Link the new block in after the original
+	split.Previous = block;
+	split.Next = original.Next;
+	if (original.Next != INVALID_BLOCK) mBlocks[original.Next].Previous = tail;
+	original.Next = tail;
+
+	InsertFree(tail);
+}
+
+void BlockAllocator::MergeIntoPrevious(std::uint32_t block)
+{
+	auto previous = mBlocks[block].Previous;
+	auto next = mBlocks[block].Next;
+	mBlocks[previous].Size += mBlocks[block].Size;
+	mBlocks[previous].Next = next;
+	if (next != INVALID_BLOCK) mBlocks[next].Previous = previous;
+
+	mBlocks[block] = Block();
+	mUnusedBlocks.push_back(block);
+}
+
+std::uint32_t BlockAllocator::NewBlock()
+{
+	if (!mUnusedBlocks.empty())
+	{
+		auto block = mUnusedBlocks.back();
+		mUnusedBlocks.pop_back();
+		return block;
+	}
+	mBlocks.emplace_back();
+	return std::uint32_t(mBlocks.size() - 1);
+}
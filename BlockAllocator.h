@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Two level segregated fit allocator for ranges of a large block of memory. Only offsets are handed
+// out, so it can manage GPU buffers, heaps or anything else addressed by offset. Allocation and
+// freeing take constant time; freed ranges merge with free neighbours straight away.
+// Not thread safe
+class BlockAllocator
+{
+public:
+	static const std::uint32_t INVALID_BLOCK = ~0u;
+
+	struct Allocation
+	{
+		std::uint64_t Offset = 0;
+		std::uint64_t Size = 0;
+		std::uint32_t Block = INVALID_BLOCK;
+
+		bool IsValid() const { return Block != INVALID_BLOCK; }
+	};
+
+	struct Stats
+	{
+		std::uint64_t Capacity = 0;
+		std::uint64_t UsedBytes = 0;
+		std::uint64_t FreeBytes = 0;
+		std::uint64_t LargestFreeBlock = 0;
+		std::uint32_t NumAllocations = 0;
+		std::uint32_t NumFreeBlocks = 0;
+
+		// Share of the free space that is not in the largest free block, zero when it is all in one piece
+		float Fragmentation() const { return FreeBytes ? 1.0f - float(LargestFreeBlock) / float(FreeBytes) : 0.0f; }
+	};
+
+	BlockAllocator(std::uint64_t capacity);
+
+	// Find room for size bytes at an offset that is a multiple of alignment, which must be a power of two.
+	// Returns false if there is no free range large enough
+	bool Allocate(std::uint64_t size, std::uint64_t alignment, Allocation& allocation);
+
+	// Give back an allocation, which is reset
+	void Free(Allocation& allocation);
+
+	Stats GetStats() const;
+	std::uint64_t Capacity() const { return mCapacity; }
+	bool IsEmpty() const { return mNumAllocations == 0; }
+
+private:
+	// Free lists are split by the highest set bit of the size, then into linear steps within that power of two
+	static const int SECOND_LEVEL_BITS = 4;
+	static const int NUM_SECOND_LEVELS = 1 << SECOND_LEVEL_BITS;
+	static const int NUM_FIRST_LEVELS = 64;
+
+	// Ranges are never split into pieces smaller than this
+	static const std::uint64_t MIN_BLOCK_SIZE = 16;
+
+	struct Block
+	{
+		std::uint64_t Offset = 0;
+		std::uint64_t Size = 0;
+
+		// Neighbours in memory, and in the block's free list while it is free
+		std::uint32_t Previous = INVALID_BLOCK;
+		std::uint32_t Next = INVALID_BLOCK;
+		std::uint32_t PreviousFree = INVALID_BLOCK;
+		std::uint32_t NextFree = INVALID_BLOCK;
+		bool Free = false;
+	};
+
+	// Free list a block of this size goes in
+	static void MapSize(std::uint64_t size, int& firstLevel, int& secondLevel);
+
+	// First free block at least this large, or INVALID_BLOCK
+	std::uint32_t FindFreeBlock(std::uint64_t size);
+
+	void InsertFree(std::uint32_t block);
+	void RemoveFree(std::uint32_t block);
+
+	// Split the end of a block off into a new free block
+	void SplitTail(std::uint32_t block, std::uint64_t size);
+
+	// Merge a block into the one before it in memory, releasing its record
+	void MergeIntoPrevious(std::uint32_t block);
+
+	std::uint32_t NewBlock();
+
+	std::uint64_t mCapacity;
+	std::uint64_t mUsedBytes = 0;
+	std::uint32_t mNumAllocations = 0;
+
+	std::vector<Block> mBlocks;
+	std::vector<std::uint32_t> mUnusedBlocks;
+
+	// Bit set for each first level with a free block, and for each second level within it
+	std::uint64_t mFirstLevelMask = 0;
+	std::uint32_t mSecondLevelMasks[NUM_FIRST_LEVELS] = {};
+	std::uint32_t mFreeLists[NUM_FIRST_LEVELS][NUM_SECOND_LEVELS];
+};
@@ -0,0 +1,57 @@
+#include "ChunkCache.h"
+
+ChunkCache::ChunkCache(size_t capacity)
+{
+	mCapacity = capacity;
+}
+
+void ChunkCache::Store(const ChunkKey& key, std::vector<PlanetVertex>&& vertices)
+{
+	if (mCapacity == 0) return;
+
+	// Replace an older copy of the same chunk
+	auto existing = mLookup.find(key);
+	if (existing != mLookup.end())
+	{
+		mBytes -= existing->second->second.size() * sizeof(PlanetVertex);
+		mEntries.erase(existing->second);
+		mLookup.erase(existing);
+	}
+
+	// Evict the least recently used chunk
+	if (mEntries.size() >= mCapacity)
+	{
+		mBytes -= mEntries.back().second.size() * sizeof(PlanetVertex);
+		mLookup.erase(mEntries.back().first);
+		mEntries.pop_back();
+	}
+
+	mBytes += vertices.size() * sizeof(PlanetVertex);
+	mEntries.emplace_front(key, std::move(vertices));
+	mLookup[key] = mEntries.begin();
+}
+
+bool ChunkCache::Take(const ChunkKey& key, std::vector<PlanetVertex>& vertices)
+{
+	auto entry = mLookup.find(key);
+	if (entry == mLookup.end())
+	{
+		mMisses++;
+		return false;
+	}
+
+	// The chunk owns the vertices again until it is next merged
+	vertices = std::move(entry->second->second);
+	mBytes -= vertices.size() * sizeof(PlanetVertex);
+	mEntries.erase(entry->second);
+	mLookup.erase(entry);
+	mHits++;
+	return true;
+}
+
+void ChunkCache::Clear()
+{
+	mEntries.clear();
+	mLookup.clear();
+	mBytes = 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "PlanetVertex.h"
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// Identifies a chunk's geometry, which only depends on where the node is in the tree and the noise settings
+struct ChunkKey
+{
+	std::uint64_t Path = 0;
+	int Seed = 0;
+	float Frequency = 0;
+	int Octaves = 0;
+
+	bool operator==(const ChunkKey& other) const
+	{
+		return Path == other.Path && Seed == other.Seed && Frequency == other.Frequency && Octaves == other.Octaves;
+	}
+};
+
+struct ChunkKeyHash
+{
+	size_t operator()(const ChunkKey& key) const
+	{
+		auto hash = std::hash<std::uint64_t>()(key.Path);
+		hash ^= std::hash<int>()(key.Seed) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		hash ^= std::hash<float>()(key.Frequency) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		hash ^= std::hash<int>()(key.Octaves) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+};
+
+// Least recently used cache of built chunk vertices, so chunks merged away and split again
+// are not rebuilt. Only used from the main thread
+class ChunkCache
+{
+public:
+	ChunkCache(size_t capacity = 128);
+
+	// Move a chunk's vertices into the cache, evicting the least recently used chunk if full
+	void Store(const ChunkKey& key, std::vector<PlanetVertex>&& vertices);
+
+	// Move a chunk's vertices out of the cache, returning false if they are not cached
+	bool Take(const ChunkKey& key, std::vector<PlanetVertex>& vertices);
+
+	void Clear();
+
+	size_t Size() const { return mEntries.size(); }
+	size_t Capacity() const { return mCapacity; }
+
+	// Bytes of vertices held by the cache
+	size_t SizeInBytes() const { return mBytes; }
+
+	// Lookups since the cache was created
+	int mHits = 0;
+	int mMisses = 0;
+private:
+	typedef std::pair<ChunkKey, std::vector<PlanetVertex>> Entry;
+
+	// Most recently stored at the front
+	std::list<Entry> mEntries;
+	std::unordered_map<ChunkKey, std::list<Entry>::iterator, ChunkKeyHash> mLookup;
+
+	size_t mCapacity;
+	size_t mBytes = 0;
+};
@@ -0,0 +1,240 @@
+#include "ChunkDiskCache.h"
+#include "PlanetSurface.h"
+#include <cmath>
+#include <cstring>
+
+bool ChunkDiskCache::Open(const std::string& directory, const ChunkDiskParams& params)
+{
+	Close();
+	if (directory.empty() || params.NumVertices <= 0) return false;
+
+	mParams = params;
+	auto dataSize = params.NumVertices * sizeof(PackedChunkVertex);
+	mRecordSize = sizeof(RecordHeader) + ((dataSize + 7) & ~size_t(7));
+
+	// Name the file after the parameters so each planet keeps its own file
+	std::uint32_t frequencyBits;
+	std::memcpy(&frequencyBits, &params.Frequency, sizeof(frequencyBits));
+	auto fileName = directory + "/Planet_" + std::to_string(params.Seed) + "_" + std::to_string(frequencyBits) + "_" +
+		std::to_string(params.Octaves) + "_" + std::to_string(params.NumVertices) + ".chunks";
+
+	// Fails harmlessly if the directory exists
+	CreateDirectoryA(directory.c_str(), nullptr);
+	mFile = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(mFile, &fileSize))
+	{
+		Close();
+		return false;
+	}
+	std::uint64_t size = fileSize.QuadPart;
+
+	// Index the records that survived the last session
+	std::uint64_t validSize = 0;
+	if (size >= sizeof(FileHeader) && Map(size)) validSize = ReadIndex();
+
+	if (validSize == 0)
+	{
+		// New, stale or unreadable file, start again with a fresh header
+		Unmap();
+		mIndex.clear();
+		FileHeader header = { FILE_MAGIC, FILE_VERSION, params.Seed, params.Frequency, params.Octaves, std::uint32_t(params.NumVertices) };
+		DWORD written = 0;
+		if (!Truncate(0) || !WriteFile(mFile, &header, sizeof(header), &written, nullptr) || written != sizeof(header))
+		{
+			Close();
+			return false;
+		}
+		validSize = sizeof(header);
+	}
+	else if (validSize < size)
+	{
+		// Cut off a record left half written, the mapping has to be closed to shrink the file
+		Unmap();
+		if (!Truncate(validSize) || !Map(validSize))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	mFileSize = validSize;
+	mWritable = true;
+	return true;
+}
+
+void ChunkDiskCache::Close()
+{
+	Flush();
+	Unmap();
+	if (mFile != INVALID_HANDLE_VALUE) CloseHandle(mFile);
+	mFile = INVALID_HANDLE_VALUE;
+	mFileSize = 0;
+	mWritable = false;
+	mIndex.clear();
+}
+
+const PackedChunkVertex* ChunkDiskCache::Find(std::uint64_t path)
+{
+	auto record = mIndex.find(path);
+
+	// Records appended this session are past the end of the mapping
+	if (record == mIndex.end() || record->second + mRecordSize > mMappedSize)
+	{
+		mMisses++;
+		return nullptr;
+	}
+
+	mHits++;
+	return reinterpret_cast<const PackedChunkVertex*>(mView + record->second + sizeof(RecordHeader));
+}
+
+void ChunkDiskCache::Append(std::uint64_t path, const std::vector<PlanetVertex>& vertices)
+{
+	if (!mWritable || vertices.size() != size_t(mParams.NumVertices) || mIndex.count(path)) return;
+
+	// Take a buffer a finished write has given back
+	std::vector<std::uint8_t>* record = nullptr;
+	{
+		std::unique_lock<std::mutex> l(mWriteLock);
+		if (!mFreeWriteBuffers.empty())
+		{
+			record = mFreeWriteBuffers.back();
+			mFreeWriteBuffers.pop_back();
+		}
+	}
+	if (!record)
+	{
+		mWriteBuffers.push_back(std::make_unique<std::vector<std::uint8_t>>());
+		record = mWriteBuffers.back().get();
+	}
+
+	// Pack the record
+	record->assign(mRecordSize, 0);
+	auto packed = reinterpret_cast<PackedChunkVertex*>(record->data() + sizeof(RecordHeader));
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		packed[i] = Encode(vertices[i]);
+	}
+	RecordHeader header = { path, Checksum(record->data() + sizeof(RecordHeader), mRecordSize - sizeof(RecordHeader)), 0 };
+	std::memcpy(record->data(), &header, sizeof(header));
+
+	// Claim the end of the file and write it there on the writer thread. Records appended this session
+	// are past the end of the mapping, so Find never reads one still being written
+	auto offset = mFileSize;
+	mIndex[path] = offset;
+	mFileSize += mRecordSize;
+	mWriter.AddJob([this, record, offset]() { WriteRecord(record, offset); });
+}
+
+void ChunkDiskCache::WriteRecord(std::vector<std::uint8_t>* record, std::uint64_t offset)
+{
+	// Writes after a failed one are skipped, they would leave a gap in the records
+	if (mWritable)
+	{
+		OVERLAPPED position = {};
+		position.Offset = DWORD(offset);
+		position.OffsetHigh = DWORD(offset >> 32);
+		DWORD written = 0;
+		if (!WriteFile(mFile, record->data(), DWORD(record->size()), &written, &position) || written != record->size())
+		{
+			// Disk full or read only, keep reading what is there. A partial record is cut off next time the file is opened
+			mWritable = false;
+		}
+	}
+
+	std::unique_lock<std::mutex> l(mWriteLock);
+	mFreeWriteBuffers.push_back(record);
+}
+
+void ChunkDiskCache::Flush()
+{
+	mWriter.Wait();
+}
+
+PackedChunkVertex ChunkDiskCache::Encode(const PlanetVertex& vertex)
+{
+	PackedChunkVertex packed;
+
+	// Height above the unit sphere
+	auto height = (Distance(vertex.Pos, XMFLOAT3{ 0,0,0 }) - 1.0f) / PlanetSurface::MAX_ELEVATION;
+	height = height < -1.0f ? -1.0f : height > 1.0f ? 1.0f : height;
+	packed.Height = std::int16_t(std::lround(height * 32767.0f));
+
+	packed.Normal[0] = vertex.Normal[0];
+	packed.Normal[1] = vertex.Normal[1];
+	return packed;
+}
+
+float ChunkDiskCache::DecodeHeight(const PackedChunkVertex& packed)
+{
+	return packed.Height / 32767.0f * PlanetSurface::MAX_ELEVATION;
+}
+
+bool ChunkDiskCache::Map(std::uint64_t size)
+{
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, DWORD(size >> 32), DWORD(size), nullptr);
+	if (!mMapping) return false;
+
+	mView = static_cast<const std::uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, size_t(size)));
+	if (!mView)
+	{
+		Unmap();
+		return false;
+	}
+
+	mMappedSize = size;
+	return true;
+}
+
+void ChunkDiskCache::Unmap()
+{
+	if (mView) UnmapViewOfFile(mView);
+	if (mMapping) CloseHandle(mMapping);
+	mView = nullptr;
+	mMapping = nullptr;
+	mMappedSize = 0;
+}
+
+bool ChunkDiskCache::Truncate(std::uint64_t size)
+{
+	LARGE_INTEGER offset;
+	offset.QuadPart = size;
+	return SetFilePointerEx(mFile, offset, nullptr, FILE_BEGIN) && SetEndOfFile(mFile);
+}
+
+std::uint64_t ChunkDiskCache::ReadIndex()
+{
+	// The file must have been written with the same parameters
+	FileHeader header;
+	std::memcpy(&header, mView, sizeof(header));
+	if (header.Magic != FILE_MAGIC || header.Version != FILE_VERSION || header.Seed != mParams.Seed ||
+		header.Frequency != mParams.Frequency || header.Octaves != mParams.Octaves || header.NumVertices != std::uint32_t(mParams.NumVertices))
+	{
+		return 0;
+	}
+
+	// Stop at the first record that is cut short or does not match its checksum
+	std::uint64_t offset = sizeof(FileHeader);
+	for (; offset + mRecordSize <= mMappedSize; offset += mRecordSize)
+	{
+		RecordHeader record;
+		std::memcpy(&record, mView + offset, sizeof(record));
+		if (record.Checksum != Checksum(mView + offset + sizeof(RecordHeader), mRecordSize - sizeof(RecordHeader))) break;
+		mIndex[record.Path] = offset;
+	}
+	return offset;
+}
+
+std::uint32_t ChunkDiskCache::Checksum(const std::uint8_t* data, size_t size)
+{
+	// FNV-1a
+	std::uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return hash;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "PlanetVertex.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Chunk vertex as saved on disk. Positions come from the chunk's corners, so only the
+// height above the unit sphere and an octahedral normal are kept
+struct PackedChunkVertex
+{
+	std::int16_t Height;
+	std::int16_t Normal[2];
+};
+
+// Planet parameters the saved geometry depends on, a file is only used if they all match
+struct ChunkDiskParams
+{
+	int Seed = 0;
+	float Frequency = 0;
+	int Octaves = 0;
+	int NumVertices = 0;
+};
+
+// Chunk geometry saved between sessions, one file per parameter set. The file is read through
+// a memory mapping so loading a chunk costs a page fault instead of noise evaluation. Chunks
+// built this session are appended to the file by a writer thread and can be read from the next session.
+// Open, Close, Find, Append and Flush are main thread only; data returned by Find may be read
+// by any thread until the cache is next opened or closed.
+class ChunkDiskCache
+{
+public:
+	~ChunkDiskCache() { Close(); }
+
+	// Open or create the file for a parameter set in a directory, an empty directory disables the cache.
+	// Stale files are started again and a truncated or corrupt tail is cut off
+	bool Open(const std::string& directory, const ChunkDiskParams& params);
+	void Close();
+	bool IsOpen() const { return mFile != INVALID_HANDLE_VALUE; }
+
+	// Get a chunk's saved vertices, or nullptr if it is not in the mapped part of the file
+	const PackedChunkVertex* Find(std::uint64_t path);
+
+	// Save a chunk's vertices if the chunk is not already in the file. The record is packed here and
+	// written by the writer thread, so the caller does not wait on the disk
+	void Append(std::uint64_t path, const std::vector<PlanetVertex>& vertices);
+
+	// Wait for appended records to reach the file
+	void Flush();
+
+	// Convert between vertices and their saved form, the normal is kept as it is packed
+	static PackedChunkVertex Encode(const PlanetVertex& vertex);
+	static float DecodeHeight(const PackedChunkVertex& packed);
+
+	// Lookups since the cache was created
+	int mHits = 0;
+	int mMisses = 0;
+private:
+	struct FileHeader
+	{
+		std::uint32_t Magic;
+		std::uint32_t Version;
+		std::int32_t Seed;
+		float Frequency;
+		std::int32_t Octaves;
+		std::uint32_t NumVertices;
+	};
+
+	// Each record is a header followed by NumVertices packed vertices, padded to 8 bytes
+	struct RecordHeader
+	{
+		std::uint64_t Path;
+		std::uint32_t Checksum;
+		std::uint32_t Pad;
+	};
+
+	static const std::uint32_t FILE_MAGIC = 0x4b4e4843; // "CHNK"
+	static const std::uint32_t FILE_VERSION = 3;
+
+	// Map the first size bytes of the file for reading
+	bool Map(std::uint64_t size);
+	void Unmap();
+
+	// Cut the file off at a size
+	bool Truncate(std::uint64_t size);
+
+	// Fill the index from the mapped records, returning the end of the last valid record or 0 if the header does not match
+	std::uint64_t ReadIndex();
+
+	static std::uint32_t Checksum(const std::uint8_t* data, size_t size);
+
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+	const std::uint8_t* mView = nullptr;
+	std::uint64_t mMappedSize = 0;
+
+	// End of the file, where records are appended. Cleared by the writer if a write fails
+	std::uint64_t mFileSize = 0;
+	std::atomic<bool> mWritable = false;
+
+	ChunkDiskParams mParams;
+	size_t mRecordSize = 0;
+
+	// Offset of each saved chunk's record by path
+	std::unordered_map<std::uint64_t, std::uint64_t> mIndex;
+
+	// Records being written and records free for the next append, kept so appending does not allocate
+	std::vector<std::unique_ptr<std::vector<std::uint8_t>>> mWriteBuffers;
+	std::vector<std::vector<std::uint8_t>*> mFreeWriteBuffers;
+	std::mutex mWriteLock;
+
+	// Write a packed record at its offset, on the writer thread
+	void WriteRecord(std::vector<std::uint8_t>* record, std::uint64_t offset);
+
+	// One thread so records are written one at a time
+	ThreadPool mWriter{ 1 };
+};
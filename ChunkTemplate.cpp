@@ -0,0 +1,90 @@
+#include "ChunkTemplate.h"
+#include <stdexcept>
+
+ChunkTemplate::ChunkTemplate(int lod)
+{
+	mLOD = lod;
+
+	// (n + 1)(n + 2) / 2 vertices and n^2 triangles for n = 2^LOD segments per side
+	int segments = 1 << mLOD;
+	int numVertices = (segments + 1) * (segments + 2) / 2;
+	mBarycentrics.reserve(numVertices);
+	mIndices.reserve(segments * segments * 3);
+	EdgeVertexMap vertexMap(numVertices);
+
+	// Start with the corners
+	mBarycentrics.push_back({ 1,0,0 });
+	mBarycentrics.push_back({ 0,1,0 });
+	mBarycentrics.push_back({ 0,0,1 });
+
+	std::vector<Triangle> triangles;
+	triangles.push_back({ 0,1,2 });
+
+	// Subdivide triangles
+	for (int i = 0; i < mLOD; i++)
+	{
+		std::vector<Triangle> newTriangles;
+		newTriangles.reserve(triangles.size() * 4);
+
+		for (const auto& triangle : triangles)
+		{
+			SubdivideTriangle(vertexMap, triangle, newTriangles);
+		}
+		triangles.swap(newTriangles);
+	}
+
+	// Create final index lists
+	for (const auto& triangle : triangles)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			mIndices.push_back(triangle.Point[i]);
+			mGPUIndices.push_back(uint16_t(triangle.Point[i]));
+		}
+	}
+}
+
+ChunkTemplate::~ChunkTemplate()
+{
+	if (MeshBufferHeap) MeshBufferHeap->Free(mIndexAllocation);
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS ChunkTemplate::GetIndexBuffer(ID3D12GraphicsCommandList* commandList)
+{
+	if (!mIndexAllocation.IsValid())
+	{
+		const UINT iBSize = (UINT)mGPUIndices.size() * sizeof(uint16_t);
+		mIndexAllocation = MeshBufferHeap->Upload(commandList, mGPUIndices.data(), iBSize);
+		if (!mIndexAllocation.IsValid()) throw std::runtime_error("Failed to allocate chunk index buffer");
+	}
+	return mIndexAllocation.Address;
+}
+
+int ChunkTemplate::GetVertexForEdge(EdgeVertexMap& vertexMap, int v1, int v2)
+{
+	// Either create or reuse vertices
+	return vertexMap.GetOrCreate(v1, v2, [&]()
+	{
+		// Midpoint weights are the average of the edge's weights
+		auto& edge1 = mBarycentrics[v1];
+		auto& edge2 = mBarycentrics[v2];
+		mBarycentrics.push_back(Midpoint(edge1, edge2));
+		return int(mBarycentrics.size() - 1);
+	});
+}
+
+void ChunkTemplate::SubdivideTriangle(EdgeVertexMap& vertexMap, Triangle triangle, std::vector<Triangle>& newTriangles)
+{
+	// For each edge
+	std::uint32_t mid[3];
+	for (int i = 0; i < 3; i++)
+	{
+		mid[i] = GetVertexForEdge(vertexMap, triangle.Point[i], triangle.Point[(i + 1) % 3]);
+	}
+
+	// Add triangles to new array
+	newTriangles.push_back({ triangle.Point[0], mid[0], mid[2] });
+	newTriangles.push_back({ triangle.Point[1], mid[1], mid[0] });
+	newTriangles.push_back({ triangle.Point[2], mid[2], mid[1] });
+	newTriangles.push_back({ mid[0], mid[1], mid[2] });
+}
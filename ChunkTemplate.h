@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Utility.h"
+#include "EdgeVertexMap.h"
+#include "GpuBufferHeap.h"
+#include <vector>
+#include <cstdint>
+
+// Topology shared by every TriangleChunk. The chunk triangle is subdivided once and each
+// vertex is stored as barycentric weights of the three corners, so building a chunk only
+// needs to evaluate positions and noise. All chunks draw with the same 16-bit index buffer.
+class ChunkTemplate
+{
+public:
+	ChunkTemplate(int lod = 6);
+	~ChunkTemplate();
+
+	// Get the address of the shared index buffer in the mesh buffer heap, uploading it on first use. Main thread only
+	D3D12_GPU_VIRTUAL_ADDRESS GetIndexBuffer(ID3D12GraphicsCommandList* commandList);
+
+	// Weights of corners 0, 1 and 2 for each vertex, the first three vertices are the corners
+	std::vector<XMFLOAT3> mBarycentrics;
+
+	// Indices for CPU side normal calculation and for the GPU
+	std::vector<uint32_t> mIndices;
+	std::vector<uint16_t> mGPUIndices;
+
+	// Number of subdivisions
+	int mLOD = 6;
+
+private:
+	// Get vertex for triangle edge
+	int GetVertexForEdge(EdgeVertexMap& vertexMap, int v1, int v2);
+
+	// Subdivide triangle
+	void SubdivideTriangle(EdgeVertexMap& vertexMap, Triangle triangle, std::vector<Triangle>& newTriangles);
+
+	// Space for the shared index buffer in the mesh buffer heap
+	GpuBufferHeap::Allocation mIndexAllocation;
+};
@@ -5,8 +5,6 @@
 #include <vector>
 #include <memory>
 
-const int MAX_PLANET_VERTS = 25000;
-
 extern std::vector<std::unique_ptr<FrameResource>> FrameResources;
 extern int CurrentFrameResourceIndex;
 extern unique_ptr<SRVDescriptorHeap> SrvDescriptorHeap;
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Sorted set of element ranges, with overlapping and touching ranges merged so each element
+// is only copied once however many times it was marked
+class DirtyIntervals
+{
+public:
+	struct Interval
+	{
+		std::uint32_t First;
+		std::uint32_t Count;
+	};
+
+	// Mark count elements from first
+	void Add(std::uint32_t first, std::uint32_t count)
+	{
+		if (count == 0) return;
+		std::uint32_t last = first + count;
+
+		// Find the first interval ending at or after the new one's start
+		auto it = std::lower_bound(mIntervals.begin(), mIntervals.end(), first,
+			[](const Interval& interval, std::uint32_t value) { return interval.First + interval.Count < value; });
+
+		// Swallow every interval the new one overlaps or touches
+		auto end = it;
+		while (end != mIntervals.end() && end->First <= last)
+		{
+			first = end->First < first ? end->First : first;
+			last = end->First + end->Count > last ? end->First + end->Count : last;
+			end++;
+		}
+
+		if (it == end)
+		{
+			mIntervals.insert(it, { first, last - first });
+			return;
+		}
+		*it = { first, last - first };
+		mIntervals.erase(it + 1, end);
+	}
+
+	// Mark every interval of another set
+	void Add(const DirtyIntervals& other)
+	{
+		for (auto& interval : other.mIntervals) Add(interval.First, interval.Count);
+	}
+
+	void Clear() { mIntervals.clear(); }
+	bool Empty() const { return mIntervals.empty(); }
+
+	const std::vector<Interval>& Intervals() const { return mIntervals; }
+
+private:
+	std::vector<Interval> mIntervals;
+};
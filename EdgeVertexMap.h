@@ -0,0 +1,192 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+// Open addressed table mapping a triangle edge to the vertex created at its midpoint.
+// Lookups and inserts are lock free so several threads can subdivide at once.
+// Reserve and Clear must only be called when no other thread is using the table.
+class EdgeVertexMap
+{
+public:
+	EdgeVertexMap(size_t numEdges = 1024) { Reserve(numEdges); }
+
+	// Pack an edge into a key, normalising the edge direction to prevent duplication
+	static uint64_t PackEdge(uint32_t v1, uint32_t v2)
+	{
+		if (v1 > v2) std::swap(v1, v2);
+		return (uint64_t(v1) << 32) | v2;
+	}
+
+	// Make room for at least this many edges, rehashing existing entries if the table grows
+	void Reserve(size_t numEdges)
+	{
+		// Keep the load factor at or below one half so probe sequences stay short
+		size_t capacity = 16;
+		while (capacity < numEdges * 2) capacity *= 2;
+		if (capacity <= mCapacity) return;
+
+		auto oldSlots = std::move(mSlots);
+		auto oldCapacity = mCapacity;
+
+		mSlots = std::make_unique<Slot[]>(capacity);
+		mCapacity = capacity;
+		mMask = capacity - 1;
+		mSize.store(0, std::memory_order_relaxed);
+		for (size_t i = 0; i < capacity; i++)
+		{
+			mSlots[i].Key.store(EMPTY_KEY, std::memory_order_relaxed);
+			mSlots[i].Value.store(PENDING_VALUE, std::memory_order_relaxed);
+		}
+
+		// Move the old entries into the new slots
+		for (size_t i = 0; i < oldCapacity; i++)
+		{
+			auto key = oldSlots[i].Key.load(std::memory_order_relaxed);
+			if (key == EMPTY_KEY) continue;
+			auto& slot = mSlots[FindSlot(key)];
+			slot.Key.store(key, std::memory_order_relaxed);
+			slot.Value.store(oldSlots[i].Value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			mSize.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// Remove all edges, keeping the current capacity
+	void Clear()
+	{
+		for (size_t i = 0; i < mCapacity; i++)
+		{
+			mSlots[i].Key.store(EMPTY_KEY, std::memory_order_relaxed);
+			mSlots[i].Value.store(PENDING_VALUE, std::memory_order_relaxed);
+		}
+		mSize.store(0, std::memory_order_relaxed);
+	}
+
+	// Remove an edge, returning false if it was not in the table. Like Reserve and Clear,
+	// this must only be called when no other thread is using the table
+	bool Erase(uint32_t v1, uint32_t v2)
+	{
+		auto key = PackEdge(v1, v2);
+		size_t hole = FindSlot(key);
+		if (mSlots[hole].Key.load(std::memory_order_relaxed) != key) return false;
+
+		// Shift later entries of the probe run back, so lookups never stop early at the hole
+		for (size_t i = (hole + 1) & mMask; ; i = (i + 1) & mMask)
+		{
+			auto slotKey = mSlots[i].Key.load(std::memory_order_relaxed);
+			if (slotKey == EMPTY_KEY) break;
+
+			// An entry can fill the hole if the hole lies between its home slot and where it is
+			size_t home = Hash(slotKey) & mMask;
+			if (((i - home) & mMask) >= ((i - hole) & mMask))
+			{
+				mSlots[hole].Key.store(slotKey, std::memory_order_relaxed);
+				mSlots[hole].Value.store(mSlots[i].Value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				hole = i;
+			}
+		}
+
+		mSlots[hole].Key.store(EMPTY_KEY, std::memory_order_relaxed);
+		mSlots[hole].Value.store(PENDING_VALUE, std::memory_order_relaxed);
+		mSize.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Return the vertex for an edge, or -1 if the edge has no vertex
+	int Find(uint32_t v1, uint32_t v2) const
+	{
+		auto key = PackEdge(v1, v2);
+		for (size_t i = Hash(key) & mMask, probes = 0; probes < mCapacity; i = (i + 1) & mMask, probes++)
+		{
+			auto slotKey = mSlots[i].Key.load(std::memory_order_acquire);
+			if (slotKey == EMPTY_KEY) return -1;
+			if (slotKey == key) return WaitForValue(mSlots[i]);
+		}
+		return -1;
+	}
+
+	// Return the vertex for an edge. If the edge is new, createVertex is called by exactly one
+	// thread to make the vertex and must return its index; other threads wait for that index.
+	template <typename F>
+	int GetOrCreate(uint32_t v1, uint32_t v2, F&& createVertex)
+	{
+		auto key = PackEdge(v1, v2);
+		for (size_t i = Hash(key) & mMask, probes = 0; probes < mCapacity; i = (i + 1) & mMask, probes++)
+		{
+			auto& slot = mSlots[i];
+			auto slotKey = slot.Key.load(std::memory_order_acquire);
+
+			// Try to claim an empty slot for this edge
+			if (slotKey == EMPTY_KEY)
+			{
+				if (slot.Key.compare_exchange_strong(slotKey, key, std::memory_order_acq_rel))
+				{
+					mSize.fetch_add(1, std::memory_order_relaxed);
+					int vertex = createVertex();
+					slot.Value.store(vertex, std::memory_order_release);
+					return vertex;
+				}
+				// Another thread claimed the slot first, slotKey now holds its edge
+			}
+
+			if (slotKey == key) return WaitForValue(slot);
+		}
+		throw std::runtime_error("Edge vertex map is full");
+	}
+
+	size_t Size() const { return mSize.load(std::memory_order_relaxed); }
+	size_t Capacity() const { return mCapacity; }
+
+private:
+	static const uint64_t EMPTY_KEY = ~0ull;
+	static const int32_t PENDING_VALUE = -1;
+
+	struct Slot
+	{
+		std::atomic<uint64_t> Key;
+		std::atomic<int32_t> Value;
+	};
+
+	// Mix the edge bits so neighbouring edges spread across the table
+	static size_t Hash(uint64_t key)
+	{
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdull;
+		key ^= key >> 33;
+		key *= 0xc4ceb9fe1a85ec53ull;
+		key ^= key >> 33;
+		return size_t(key);
+	}
+
+	// Find the slot holding a key or the first empty slot for it (single threaded)
+	size_t FindSlot(uint64_t key) const
+	{
+		size_t i = Hash(key) & mMask;
+		while (true)
+		{
+			auto slotKey = mSlots[i].Key.load(std::memory_order_relaxed);
+			if (slotKey == EMPTY_KEY || slotKey == key) return i;
+			i = (i + 1) & mMask;
+		}
+	}
+
+	// Wait for the thread that claimed a slot to publish its vertex
+	static int WaitForValue(const Slot& slot)
+	{
+		int value;
+		while ((value = slot.Value.load(std::memory_order_acquire)) == PENDING_VALUE)
+		{
+			std::this_thread::yield();
+		}
+		return value;
+	}
+
+	std::unique_ptr<Slot[]> mSlots;
+	size_t mCapacity = 0;
+	size_t mMask = 0;
+	std::atomic<size_t> mSize = 0;
+};
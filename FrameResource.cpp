@@ -1,11 +1,27 @@
 #include "FrameResource.h"
 
-FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT planetMaxVertexCount, UINT planetMaxIndexCount, UINT materialCount)
+FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount)
 {
 	device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(mCommandAllocator.GetAddressOf()));
 	mPerFrameConstantBuffer = std::make_unique<UploadBuffer<PerFrameConstants>>(device, passCount, true);
 	mPerObjectConstantBuffer = std::make_unique<UploadBuffer<PerObjectConstants>>(device, objectCount, true);
 	mPerMaterialConstantBuffer = std::make_unique<UploadBuffer<PerMaterialConstants>>(device, materialCount, true);
-	mPlanetVB = std::make_unique<UploadBuffer<Vertex>>(device, planetMaxVertexCount, false);
-	mPlanetIB = std::make_unique<UploadBuffer<uint32_t>>(device, planetMaxIndexCount, false);
+	ReservePlanetVertices(device, 0);
+	mPlanetIB = std::make_unique<PagedUploadBuffer<uint32_t>>(device, PLANET_INDEX_PAGE);
+}
+
+void FrameResource::ReservePlanetVertices(ID3D12Device* device, UINT vertexCount)
+{
+	// Grow when full, shrink once two pages are unused
+	UINT pages = vertexCount / PLANET_VERTEX_PAGE + 1;
+	if (mPlanetVB && pages <= mPlanetVertexPages && pages + 2 > mPlanetVertexPages) return;
+
+	mPlanetVertexPages = pages;
+	mPlanetVB = std::make_unique<UploadBuffer<Vertex>>(device, pages * PLANET_VERTEX_PAGE, false);
+	mPlanetVB->MarkAllDirty();
+}
+
+size_t FrameResource::GetPlanetBufferBytes() const
+{
+	return size_t(mPlanetVertexPages) * PLANET_VERTEX_PAGE * sizeof(Vertex) + mPlanetIB->SizeInBytes();
 }
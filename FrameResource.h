@@ -2,15 +2,20 @@
 #pragma once
 
 #include "UploadBuffer.h"
+#include "PagedUploadBuffer.h"
 #include <d3d12.h>
 #include "d3dx12.h"
 #include <memory>
+#include <vector>
 
+// Planet buffers grow and shrink in pages of this many elements. Index pages hold whole triangles
+const UINT PLANET_VERTEX_PAGE = 16384;
+const UINT PLANET_INDEX_PAGE = 3 * 16384;
 
 class FrameResource
 {
 public:
-    FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT planetMaxVertexCount, UINT planetMaxIndexCount, UINT materialCount);
+    FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount);
 
 	ComPtr<ID3D12CommandAllocator> mCommandAllocator;
 
@@ -18,10 +23,20 @@ public:
     std::unique_ptr <UploadBuffer<PerFrameConstants>> mPerFrameConstantBuffer;
     std::unique_ptr <UploadBuffer<PerMaterialConstants>> mPerMaterialConstantBuffer;
 
+    // Planet geometry, each buffer tracks the ranges changed since it was last written. Vertices are
+    // indexed from any page of indices so they are kept in one buffer, sized in whole pages
     std::unique_ptr <UploadBuffer<Vertex>> mPlanetVB;
-    std::unique_ptr <UploadBuffer<uint32_t>> mPlanetIB;
+    std::unique_ptr <PagedUploadBuffer<uint32_t>> mPlanetIB;
+
+    // Resize the planet vertex buffer in pages to hold this many vertices, keeping spare pages so small
+    // changes do not reallocate. A new buffer is marked dirty. The GPU must not be using this frame resource
+    void ReservePlanetVertices(ID3D12Device* device, UINT vertexCount);
+
+    // Bytes of upload memory held by the planet buffers
+    size_t GetPlanetBufferBytes() const;
 
     UINT64 Fence = 0;
 private:
+    UINT mPlanetVertexPages = 0;
 
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cmath>
+
+using namespace DirectX;
+
+// View frustum as six planes pointing inwards, extracted from a view projection matrix.
+// Only needs a matrix, so culling can be run without a window or device.
+class Frustum
+{
+public:
+	Frustum() {}
+	Frustum(const XMFLOAT4X4& viewProj) { Extract(viewProj); }
+
+	// Extract the planes from a row vector view projection matrix with depth from 0 to 1
+	void Extract(const XMFLOAT4X4& m)
+	{
+		mPlanes[0] = { m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41 }; // Left
+		mPlanes[1] = { m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41 }; // Right
+		mPlanes[2] = { m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42 }; // Bottom
+		mPlanes[3] = { m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42 }; // Top
+		mPlanes[4] = { m._13, m._23, m._33, m._43 };                                 // Near
+		mPlanes[5] = { m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43 }; // Far
+
+		// Normalise so plane distances are in world units
+		for (auto& plane : mPlanes)
+		{
+			float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+			plane.x /= length;
+			plane.y /= length;
+			plane.z /= length;
+			plane.w /= length;
+		}
+	}
+
+	// Is the whole sphere inside the frustum
+	bool ContainsSphere(XMFLOAT3 centre, float radius) const
+	{
+		for (auto& plane : mPlanes)
+		{
+			if (plane.x * centre.x + plane.y * centre.y + plane.z * centre.z + plane.w < radius) return false;
+		}
+		return true;
+	}
+
+	// Is any part of the sphere inside the frustum
+	bool IntersectsSphere(XMFLOAT3 centre, float radius) const
+	{
+		for (auto& plane : mPlanes)
+		{
+			if (plane.x * centre.x + plane.y * centre.y + plane.z * centre.z + plane.w < -radius) return false;
+		}
+		return true;
+	}
+
+	XMFLOAT4 mPlanes[6];
+};
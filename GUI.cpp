@@ -54,8 +54,9 @@ void GUI::Update(int numModels)
 
 	}
 
-	if (mCLOD) mMaxLOD = 6;
-	else mMaxLOD = 4;
+	// Detail is limited by the memory budget, these only keep the slider usable
+	if (mCLOD) mMaxLOD = 10;
+	else mMaxLOD = 6;
 
 	if (mLOD > mMaxLOD) mLOD = mMaxLOD;
 
@@ -64,6 +65,15 @@ void GUI::Update(int numModels)
 		mPlanetUpdated = true;
 	};
 
+	// Screen space error used to pick CLOD detail, applied without recreating the planet
+	if (mCLOD) ImGui::SliderFloat("Pixel Error", &mPixelError, 0.5f, 32.0f, "%.1f");
+
+	// Time each update may spend splitting and merging nodes
+	ImGui::SliderFloat("LOD Budget (ms)", &mLodBudget, 0.1f, 16.0f, "%.1f");
+
+	// Geometry the planet may hold, splits wait once it is reached
+	ImGui::SliderInt("Memory Budget (MB)", &mMemoryBudget, 16, 4096);
+
 	ImGui::Text("Noise");
 
 	if (ImGui::SliderFloat("Noise Freq", &mFrequency, 0.0f, 1.0f, "%.1f"))
@@ -116,6 +126,8 @@ void GUI::Update(int numModels)
 
 	if (ImGui::Checkbox("VSync", &mVSync));
 
+	if (ImGui::Checkbox("Draw Models", &mDrawModels));
+
 	if (ImGui::Checkbox("Orbit Camera", &mCameraOrbit));
 	if(!mCameraOrbit) if (ImGui::Checkbox("Invert Y", &mInvertY));
 
@@ -132,6 +144,14 @@ void GUI::Update(int numModels)
 
 	ImGui::Text("Average: %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 
+	// Mesh buffer heap use
+	if (MeshBufferHeap)
+	{
+		auto stats = MeshBufferHeap->GetStats();
+		ImGui::Text("Mesh heap: %.1f / %.1f MB in %u buffers", stats.UsedBytes / 1048576.0, stats.Capacity / 1048576.0, MeshBufferHeap->NumBuffers());
+		ImGui::Text("Mesh heap fragmentation: %.1f%% (%u free blocks)", stats.Fragmentation() * 100.0f, stats.NumFreeBlocks);
+	}
+
 	mInPosition.x = mPos[0];
 	mInPosition.y = mPos[1];
 	mInPosition.z = mPos[2];
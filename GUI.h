@@ -31,10 +31,14 @@ public:
 	float mScale = 1;
 	float mSpeedMultipler = 1;
 	bool mCLOD = false;
+	float mPixelError = 4.0f;
+	float mLodBudget = 2.0f;
+	int mMemoryBudget = 256;
 	int mDebugTex = 0.f;
 	bool mCameraOrbit = true;
 	bool mInvertY = true;
 	bool mVSync = false;
+	bool mDrawModels = false;
 	float mLightDir[3] = { -0.577f, -0.577f, 0.577f };
 
 	XMFLOAT3 mInPosition{0,0,0};
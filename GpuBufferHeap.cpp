@@ -0,0 +1,139 @@
+#include "GpuBufferHeap.h"
+
+GpuBufferHeap::GpuBufferHeap(ID3D12Device* device, UINT64 bufferSize) : mDevice(device), mBufferSize(bufferSize)
+{
+}
+
+GpuBufferHeap::Allocation GpuBufferHeap::Upload(ID3D12GraphicsCommandList* commandList, const void* data, UINT64 size, UINT64 alignment)
+{
+	Allocation allocation;
+	if (size == 0) return allocation;
+
+	// Try the existing buffers first, then add one
+	int buffer = -1;
+	for (size_t i = 0; i < mBuffers.size() && buffer < 0; i++)
+	{
+		if (mBuffers[i].Allocator && mBuffers[i].Allocator->Allocate(size, alignment, allocation.Range)) buffer = int(i);
+	}
+	if (buffer < 0)
+	{
+		buffer = CreateBuffer(size + alignment);
+		if (buffer < 0 || !mBuffers[buffer].Allocator->Allocate(size, alignment, allocation.Range)) return Allocation();
+	}
+
+	auto& target = mBuffers[buffer];
+	allocation.Buffer = UINT(buffer);
+	allocation.Address = target.Resource->GetGPUVirtualAddress() + allocation.Range.Offset;
+
+	// Stage the data in an upload buffer, kept until the copy has run
+	ComPtr<ID3D12Resource> staging;
+	if (FAILED(mDevice->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(staging.GetAddressOf()))))
+	{
+		Free(allocation);
+		return allocation;
+	}
+	void* mapped = nullptr;
+	staging->Map(0, nullptr, &mapped);
+	memcpy(mapped, data, size_t(size));
+	staging->Unmap(0, nullptr);
+	mPendingStaging.push_back(staging);
+
+	// Copy into the buffer, leaving it readable by draws
+	if (target.State != D3D12_RESOURCE_STATE_COPY_DEST)
+	{
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(target.Resource.Get(), target.State, D3D12_RESOURCE_STATE_COPY_DEST));
+	}
+	commandList->CopyBufferRegion(target.Resource.Get(), allocation.Range.Offset, staging.Get(), 0, size);
+	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(target.Resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+	target.State = D3D12_RESOURCE_STATE_GENERIC_READ;
+
+	return allocation;
+}
+
+void GpuBufferHeap::Free(Allocation& allocation)
+{
+	if (!allocation.IsValid()) return;
+	auto& buffer = mBuffers[allocation.Buffer];
+	buffer.Allocator->Free(allocation.Range);
+	allocation = Allocation();
+	if (!buffer.Allocator->IsEmpty()) return;
+
+	// Keep one empty buffer so meshes coming and going do not create and release buffers every frame
+	for (auto& other : mBuffers)
+	{
+		if (&other != &buffer && other.Allocator && other.Allocator->IsEmpty())
+		{
+			buffer = Buffer();
+			return;
+		}
+	}
+}
+
+void GpuBufferHeap::EndFrame(UINT64 fenceValue)
+{
+	for (auto& staging : mPendingStaging)
+	{
+		mRetiredStaging.push_back({ fenceValue, std::move(staging) });
+	}
+	mPendingStaging.clear();
+}
+
+void GpuBufferHeap::Collect(UINT64 completedFence)
+{
+	while (!mRetiredStaging.empty() && mRetiredStaging.front().first <= completedFence)
+	{
+		mRetiredStaging.pop_front();
+	}
+}
+
+BlockAllocator::Stats GpuBufferHeap::GetStats() const
+{
+	BlockAllocator::Stats total;
+	for (auto& buffer : mBuffers)
+	{
+		if (!buffer.Allocator) continue;
+		auto stats = buffer.Allocator->GetStats();
+		total.Capacity += stats.Capacity;
+		total.UsedBytes += stats.UsedBytes;
+		total.FreeBytes += stats.FreeBytes;
+		total.NumAllocations += stats.NumAllocations;
+		total.NumFreeBlocks += stats.NumFreeBlocks;
+		if (stats.LargestFreeBlock > total.LargestFreeBlock) total.LargestFreeBlock = stats.LargestFreeBlock;
+	}
+	return total;
+}
+
+UINT GpuBufferHeap::NumBuffers() const
+{
+	UINT count = 0;
+	for (auto& buffer : mBuffers)
+	{
+		if (buffer.Resource) count++;
+	}
+	return count;
+}
+
+int GpuBufferHeap::CreateBuffer(UINT64 size)
+{
+	Buffer buffer;
+	if (size < mBufferSize) size = mBufferSize;
+	if (FAILED(mDevice->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size), D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(buffer.Resource.GetAddressOf()))))
+	{
+		return -1;
+	}
+	buffer.Allocator = std::make_unique<BlockAllocator>(size);
+
+	// Reuse an empty slot if there is one
+	for (size_t i = 0; i < mBuffers.size(); i++)
+	{
+		if (!mBuffers[i].Resource)
+		{
+			mBuffers[i] = std::move(buffer);
+			return int(i);
+		}
+	}
+	mBuffers.push_back(std::move(buffer));
+	return int(mBuffers.size() - 1);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <windows.h>
+#include <wrl.h>
+#include <d3d12.h>
+#include "d3dx12.h"
+#include "BlockAllocator.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+// Vertex and index buffers placed inside a few large default heap buffers instead of a committed
+// resource each. Ranges are handed out by a BlockAllocator per buffer, and a new buffer is created
+// when none has room. Main thread only
+class GpuBufferHeap
+{
+public:
+	// Size of each large buffer, data larger than this gets a buffer of its own size
+	static const UINT64 DEFAULT_BUFFER_SIZE = 64ull << 20;
+
+	// Vertex and index buffer views need no more than this
+	static const UINT64 DEFAULT_ALIGNMENT = 16;
+
+	struct Allocation
+	{
+		D3D12_GPU_VIRTUAL_ADDRESS Address = 0;
+		UINT Buffer = 0;
+		BlockAllocator::Allocation Range;
+
+		bool IsValid() const { return Range.IsValid(); }
+	};
+
+	GpuBufferHeap(ID3D12Device* device, UINT64 bufferSize = DEFAULT_BUFFER_SIZE);
+
+	// Find room for data and record a copy into it on a command list. Returns an invalid allocation if a buffer could not be created
+	Allocation Upload(ID3D12GraphicsCommandList* commandList, const void* data, UINT64 size, UINT64 alignment = DEFAULT_ALIGNMENT);
+
+	// Give back an allocation the GPU has finished with, which is reset
+	void Free(Allocation& allocation);
+
+	// Staging buffers used since the last call are released once the GPU reaches fenceValue
+	void EndFrame(UINT64 fenceValue);
+
+	// Release staging buffers the GPU has finished copying from
+	void Collect(UINT64 completedFence);
+
+	// Totals over all buffers, with the largest free block of any one
+	BlockAllocator::Stats GetStats() const;
+	UINT NumBuffers() const;
+
+private:
+	struct Buffer
+	{
+		ComPtr<ID3D12Resource> Resource;
+		std::unique_ptr<BlockAllocator> Allocator;
+		D3D12_RESOURCE_STATES State = D3D12_RESOURCE_STATE_COMMON;
+	};
+
+	// Create a buffer of at least size bytes, returning its index or -1
+	int CreateBuffer(UINT64 size);
+
+	ID3D12Device* mDevice;
+	UINT64 mBufferSize;
+
+	// Released buffers leave an empty slot so allocations keep their index
+	std::vector<Buffer> mBuffers;
+
+	// Staging buffers waiting for a fence value, and those with one
+	std::vector<ComPtr<ID3D12Resource>> mPendingStaging;
+	std::deque<std::pair<UINT64, ComPtr<ID3D12Resource>>> mRetiredStaging;
+};
+
+// Heap shared by all meshes
+extern std::unique_ptr<GpuBufferHeap> MeshBufferHeap;
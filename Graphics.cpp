@@ -7,6 +7,7 @@ UINT CbvSrvUavDescriptorSize = 0;
 int CurrentFrameResourceIndex = 0;
 ComPtr<ID3D12CommandQueue> CommandQueue;
 ComPtr<ID3D12Device> D3DDevice;
+unique_ptr<GpuBufferHeap> MeshBufferHeap;
 
 Graphics::Graphics(HWND hWND, int width, int height)
 {
@@ -31,6 +32,9 @@ Graphics::Graphics(HWND hWND, int width, int height)
 	// Create SRV heap
 	SrvDescriptorHeap = make_unique<SRVDescriptorHeap>(D3DDevice.Get(), CbvSrvUavDescriptorSize);
 
+	// Create heap for mesh vertex and index buffers
+	MeshBufferHeap = make_unique<GpuBufferHeap>(D3DDevice.Get());
+
 	// Initially resize
 	Resize(width, height);
 
@@ -348,6 +352,38 @@ void Graphics::CreatePSO()
 		MessageBox(0, L"Planet Pipeline State Creation failed", L"Error", MB_OK);
 	}
 
+	// Set chunk shaders and compact vertex layout
+	psoDesc.InputLayout = { mChunkInputLayout.data(), (UINT)mChunkInputLayout.size() };
+	psoDesc.VS =
+	{
+		reinterpret_cast<BYTE*>(mChunkVSByteCode->GetBufferPointer()),
+		mChunkVSByteCode->GetBufferSize()
+	};
+	psoDesc.PS =
+	{
+		reinterpret_cast<BYTE*>(mChunkPSByteCode->GetBufferPointer()),
+		mChunkPSByteCode->GetBufferSize()
+	};
+
+	// Create Chunk PSO
+	if (FAILED(D3DDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&mChunkPSO))))
+	{
+		MessageBox(0, L"Chunk Pipeline State Creation failed", L"Error", MB_OK);
+	}
+
+	// Set fillmode to wireframe
+	psoDesc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
+
+	// Create Chunk Wireframe PSO
+	if (FAILED(D3DDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&mChunkWireframePSO))))
+	{
+		MessageBox(0, L"Chunk Wireframe Pipeline State Creation failed", L"Error", MB_OK);
+	}
+
+	// Set fillmode back to solid and the input layout back to colour
+	psoDesc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+	psoDesc.InputLayout = { mColourInputLayout.data(), (UINT)mColourInputLayout.size() };
+
 	// Set PBR shaders
 	psoDesc.VS =
 	{
@@ -456,6 +492,13 @@ void Graphics::CreateShaders()
 		{ "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 48, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
 	};
 
+	// Define compact chunk input layout, matching PlanetVertex
+	mChunkInputLayout =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+	};
+
 	// Compile colour shaders
 	mColourVSByteCode = CompileShader(L"Shaders\\shader.hlsl", nullptr, "VS", "vs_5_1");
 	mColourPSByteCode = CompileShader(L"Shaders\\shader.hlsl", nullptr, "PS", "ps_5_1");
@@ -472,6 +515,11 @@ void Graphics::CreateShaders()
 	mPlanetVSByteCode = CompileShader(L"Shaders\\planetshader.hlsl", nullptr, "VS", "vs_5_1");
 	mPlanetPSByteCode = CompileShader(L"Shaders\\planetshader.hlsl", nullptr, "PS", "ps_5_1");
 
+	// Compile chunk shaders, the planet shaders reading compact vertices
+	const D3D_SHADER_MACRO chunkDefines[] = { { "PACKED_VERTEX", "1" }, { nullptr, nullptr } };
+	mChunkVSByteCode = CompileShader(L"Shaders\\planetshader.hlsl", chunkDefines, "VS", "vs_5_1");
+	mChunkPSByteCode = CompileShader(L"Shaders\\planetshader.hlsl", chunkDefines, "PS", "ps_5_1");
+
 	// Compile sky shaders
 	mSkyVSByteCode = CompileShader(L"Shaders\\skyshader.hlsl", nullptr, "VS", "vs_5_1");
 	mSkyPSByteCode = CompileShader(L"Shaders\\skyshader.hlsl", nullptr, "PS", "ps_5_1");
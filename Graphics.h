@@ -59,6 +59,8 @@ public:
 	ComPtr<ID3D12PipelineState> mSimpleTexPSO = nullptr;
 	ComPtr<ID3D12PipelineState> mSkyPSO = nullptr;
 	ComPtr<ID3D12PipelineState> mPlanetPSO = nullptr;
+	ComPtr<ID3D12PipelineState> mChunkPSO = nullptr;
+	ComPtr<ID3D12PipelineState> mChunkWireframePSO = nullptr;
 	ComPtr<ID3D12PipelineState> mWaterPSO = nullptr;
 
 	ComPtr<ID3DBlob> mColourVSByteCode = nullptr;
@@ -69,6 +71,8 @@ public:
 	ComPtr<ID3DBlob> mSimpleTexPSByteCode = nullptr;
 	ComPtr<ID3DBlob> mPlanetVSByteCode = nullptr;
 	ComPtr<ID3DBlob> mPlanetPSByteCode = nullptr;
+	ComPtr<ID3DBlob> mChunkVSByteCode = nullptr;
+	ComPtr<ID3DBlob> mChunkPSByteCode = nullptr;
 	ComPtr<ID3DBlob> mSkyVSByteCode = nullptr;
 	ComPtr<ID3DBlob> mSkyPSByteCode = nullptr;
 	ComPtr<ID3DBlob> mWaterVSByteCode = nullptr;
@@ -76,6 +80,7 @@ public:
 
 	std::vector<D3D12_INPUT_ELEMENT_DESC> mColourInputLayout;
 	std::vector<D3D12_INPUT_ELEMENT_DESC> mTexInputLayout;
+	std::vector<D3D12_INPUT_ELEMENT_DESC> mChunkInputLayout;
 
 	D3D12_RENDER_TARGET_BLEND_DESC mTransparencyBlendDesc;
 	
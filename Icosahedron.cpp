@@ -300,94 +300,11 @@ float Icosahedron::FractalBrownianMotion(FastNoiseLite fastNoise, XMFLOAT3 fract
 
 void Icosahedron::CalculateNormals()
 {
-	// Map of vertex to triangles in Triangles array
-	int numVerts = mVertices.size();
-	std::vector<std::array<int32_t,8>> VertToTriMap;
-	for (int i = 0; i < numVerts; i++)
-	{
-		std::array<int32_t, 8> array{-1,-1,-1,-1,-1,-1,-1,-1};
-		VertToTriMap.push_back(array);
-	}
-
-	// For each triangle for each vertex add triangle to vertex array entry
-	for (int i = 0; i < mIndices.size(); i++)
-	{
-		for (int j = 0; j < 8; j++)
-		{
-			if (VertToTriMap[mIndices[i]][j] < 0)
-			{
-				VertToTriMap[mIndices[i]][j] = i / 3;
-				break;
-			}
-		}
-	}
-
-	std::vector<XMFLOAT3> NTriangles;
-
-	for (int i = 0; i < mIndices.size() / 3; i++)
-	{
-		XMFLOAT3 normal = {};
-		NTriangles.push_back(normal);
-	}
-
-	int index = 0;
-	for (int i = 0; i < NTriangles.size(); i++)
-	{
-		NTriangles[i].x = mIndices[index];
-		NTriangles[i].y = mIndices[index + 1];
-		NTriangles[i].z = mIndices[index + 2];
-		index += 3;
-	}
-
-	for (int i = 0; i < mVertices.size(); i++)
-	{
-		mNormals.push_back({ 0,0,0 });
-	}
-
-	// For each vertex collect the triangles that share it and calculate the face normal
-	for (int i = 0; i < mVertices.size(); i++)
-	{
-		for (auto& triangle : VertToTriMap[i])
-		{
-			// This shouldnt happen
-			if (triangle < 0)
-			{
-				continue;
-			}
-
-			// Get vertices from triangle index
-			auto A = mVertices[NTriangles[triangle].x];
-			auto B = mVertices[NTriangles[triangle].y];
-			auto C = mVertices[NTriangles[triangle].z];
-
-			// Calculate edges
-			auto a = XMLoadFloat3(&A.Pos);
-			auto b = XMLoadFloat3(&B.Pos);
-			auto c = XMLoadFloat3(&C.Pos);
-
-			auto E1 = XMVectorSubtract(a, c);
-			auto E2 = XMVectorSubtract(b, c);
-			
-			// Calculate normal with cross product and normalise
-			XMFLOAT3 Normal; XMStoreFloat3(&Normal, XMVector3Normalize(XMVector3Cross(E1, E2)));
-
-			mNormals[i].x += Normal.x;
-			mNormals[i].y += Normal.y;
-			mNormals[i].z += Normal.z;
-		}
-	}
-
-	// Average the face normals
-	for (auto& normal : mNormals)
-	{
-		XMFLOAT3 normalizedNormal;
-		XMStoreFloat3(&normalizedNormal, XMVector3Normalize(XMLoadFloat3(&normal)));
-		normal = normalizedNormal;
-	}
+	mNormals.resize(mVertices.size());
+	::CalculateNormals(mVertices, mIndices, mNormals);
 
 	for (int i = 0; i < mVertices.size(); i++)
 	{
 		mVertices[i].Normal = mNormals[i];
 	}
-
 }
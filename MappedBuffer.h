@@ -0,0 +1,75 @@
+#pragma once
+
+#include "DirtyIntervals.h"
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+// Typed writes into mapped buffer memory. Holds no GPU objects, so the copies can be run against
+// ordinary memory standing in for a mapped resource. Elements may be padded, as constant buffers are
+template <typename T>
+class MappedBuffer
+{
+public:
+	MappedBuffer() = default;
+	MappedBuffer(std::uint8_t* data, std::uint32_t elementCount, std::uint32_t elementSize = sizeof(T))
+	{
+		SetMapping(data, elementCount, elementSize);
+	}
+
+	void Copy(int element, const T& data)
+	{
+		std::memcpy(&mData[element * mElementSize], &data, sizeof(T));
+	}
+
+	// Write elements from firstElement, with one memcpy unless the elements are padded
+	void Write(std::uint32_t firstElement, std::span<const T> data)
+	{
+		if (firstElement + data.size() > mElementCount) throw std::runtime_error("Mapped buffer write out of range");
+		if (mElementSize == sizeof(T))
+		{
+			std::memcpy(&mData[size_t(firstElement) * mElementSize], data.data(), data.size_bytes());
+			return;
+		}
+		for (size_t i = 0; i < data.size(); i++) Copy(int(firstElement + i), data[i]);
+	}
+
+	// Queue elements to be copied from the source data by the next Flush. A buffer written from the same
+	// source as its siblings can be caught up with the ranges they were given
+	void MarkDirty(std::uint32_t first, std::uint32_t count) { mDirty.Add(first, count); }
+	void MarkDirty(const DirtyIntervals& intervals) { mDirty.Add(intervals); }
+	void MarkAllDirty() { mDirty.Clear(); mDirty.Add(0, mElementCount); }
+
+	// Copy the queued ranges from source, which is laid out like the buffer, and clear them. Ranges past
+	// the end of source are dropped, as the data they covered no longer exists
+	void Flush(std::span<const T> source)
+	{
+		auto size = source.size() < mElementCount ? std::uint32_t(source.size()) : mElementCount;
+		for (auto& interval : mDirty.Intervals())
+		{
+			if (interval.First >= size) break;
+			auto count = interval.First + interval.Count > size ? size - interval.First : interval.Count;
+			Write(interval.First, source.subspan(interval.First, count));
+		}
+		mDirty.Clear();
+	}
+
+	const DirtyIntervals& GetDirty() const { return mDirty; }
+	std::uint32_t ElementCount() const { return mElementCount; }
+
+protected:
+	// Point at mapped memory, for buffers that map after construction
+	void SetMapping(std::uint8_t* data, std::uint32_t elementCount, std::uint32_t elementSize)
+	{
+		mData = data;
+		mElementCount = elementCount;
+		mElementSize = elementSize;
+	}
+
+	std::uint8_t* mData = nullptr;
+	std::uint32_t mElementCount = 0;
+	std::uint32_t mElementSize = 0;
+
+	DirtyIntervals mDirty;
+};
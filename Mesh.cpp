@@ -1,4 +1,5 @@
 #include "Mesh.h"
+#include <stdexcept>
 
 Mesh::Mesh()
 {
@@ -6,6 +7,11 @@ Mesh::Mesh()
 
 Mesh::~Mesh()
 {
+	if (MeshBufferHeap)
+	{
+		MeshBufferHeap->Free(mVertexAllocation);
+		MeshBufferHeap->Free(mIndexAllocation);
+	}
 	if(mMaterial) delete mMaterial;
 	for (auto& tex : mTextures)
 	{
@@ -16,7 +22,7 @@ Mesh::~Mesh()
 D3D12_VERTEX_BUFFER_VIEW Mesh::GetVertexBufferView()
 {
 	D3D12_VERTEX_BUFFER_VIEW vbv;
-	vbv.BufferLocation = mGPUVertexBuffer->GetGPUVirtualAddress();
+	vbv.BufferLocation = mVertexAllocation.IsValid() ? mVertexAllocation.Address : mGPUVertexBuffer->GetGPUVirtualAddress();
 	vbv.StrideInBytes = mVertexByteStride;
 	vbv.SizeInBytes = mVertexBufferByteSize;
 	return vbv;
@@ -24,21 +30,22 @@ D3D12_VERTEX_BUFFER_VIEW Mesh::GetVertexBufferView()
 D3D12_INDEX_BUFFER_VIEW Mesh::GetIndexBufferView()
 {
 	D3D12_INDEX_BUFFER_VIEW ibv;
-	ibv.BufferLocation = mGPUIndexBuffer->GetGPUVirtualAddress();
+	if (mIndexAllocation.IsValid()) ibv.BufferLocation = mIndexAllocation.Address;
+	else if (mSharedIndexAddress) ibv.BufferLocation = mSharedIndexAddress;
+	else ibv.BufferLocation = mGPUIndexBuffer->GetGPUVirtualAddress();
 	ibv.Format = mIndexFormat;
 	ibv.SizeInBytes = mIndexBufferByteSize;
 	return ibv;
 }
-void Mesh::EmptyUploaders()
+void Mesh::CalculateDynamicBufferData()
 {
-	mVertexBufferUploader = nullptr;
-	mIndexBufferUploader = nullptr;
+	CalculateDynamicBufferData((UINT)mVertices.size(), (UINT)mIndices.size());
 }
 
-void Mesh::CalculateDynamicBufferData()
+void Mesh::CalculateDynamicBufferData(UINT vertexCount, UINT indexCount)
 {
-	UINT vbByteSize = mVertices.size() * sizeof(Vertex);
-	UINT ibByteSize = (UINT)mIndices.size() * sizeof(std::uint32_t);
+	UINT vbByteSize = vertexCount * sizeof(Vertex);
+	UINT ibByteSize = indexCount * sizeof(std::uint32_t);
 
 	mCPUVertexBuffer = nullptr;
 	mGPUVertexBuffer = nullptr;
@@ -46,38 +53,79 @@ void Mesh::CalculateDynamicBufferData()
 	mVertexByteStride = sizeof(Vertex);
 	mVertexBufferByteSize = vbByteSize;
 	mIndexBufferByteSize = ibByteSize;
-
+	mIndicesCount = indexCount;
 }
 
 void Mesh::Draw(ID3D12GraphicsCommandList* commandList)
 {
 	// Set vertex and index buffers, and draw
 	commandList->IASetVertexBuffers(0, 1, &GetVertexBufferView());
-	commandList->IASetIndexBuffer(&GetIndexBufferView());
 	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	commandList->DrawIndexedInstanced(mIndices.size(), 1, 0, 0, 0);
+	if (!mIndexPages.empty())
+	{
+		// Draw each page of indices in turn
+		for (auto& page : mIndexPages)
+		{
+			D3D12_INDEX_BUFFER_VIEW ibv = { page.Address, page.Count * UINT(sizeof(std::uint32_t)), DXGI_FORMAT_R32_UINT };
+			commandList->IASetIndexBuffer(&ibv);
+			commandList->DrawIndexedInstanced(page.Count, 1, 0, 0, 0);
+		}
+		return;
+	}
+
+	commandList->IASetIndexBuffer(&GetIndexBufferView());
+	commandList->DrawIndexedInstanced(mIndicesCount, 1, 0, 0, 0);
 }
 
 void Mesh::CalculateBufferData(ID3D12Device* d3DDevice, ID3D12GraphicsCommandList* commandList)
 {
 	mIndicesCount = mIndices.size();
-	const UINT vBSize = (UINT)mVertices.size() * sizeof(Vertex);
 	const UINT iBSize = (UINT)mIndices.size() * sizeof(std::uint32_t);
 
-	// Create CPU buffers
-	D3DCreateBlob(vBSize, &mCPUVertexBuffer);
-	CopyMemory(mCPUVertexBuffer->GetBufferPointer(), mVertices.data(), vBSize);
+	CreateVertexBuffer(d3DDevice, commandList, mVertices.data(), (UINT)mVertices.size(), sizeof(Vertex));
 
+	// Create CPU buffer
 	D3DCreateBlob(iBSize, &mCPUIndexBuffer);
 	CopyMemory(mCPUIndexBuffer->GetBufferPointer(), mIndices.data(), iBSize);
 
-	// Create GPU buffers
-	mGPUVertexBuffer = CreateDefaultBuffer(mVertices.data(), vBSize, mVertexBufferUploader, d3DDevice, commandList);
+	// Place GPU buffer in the mesh buffer heap
+	MeshBufferHeap->Free(mIndexAllocation);
+	mIndexAllocation = MeshBufferHeap->Upload(commandList, mIndices.data(), iBSize);
+	if (!mIndexAllocation.IsValid()) throw std::runtime_error("Failed to allocate mesh index buffer");
+
+	mIndexFormat = DXGI_FORMAT_R32_UINT;
+	mIndexBufferByteSize = iBSize;
+}
+
+void Mesh::CalculateBufferData(ID3D12Device* d3DDevice, ID3D12GraphicsCommandList* commandList,
+								const void* vertices, UINT vertexCount, UINT vertexStride,
+								D3D12_GPU_VIRTUAL_ADDRESS sharedIndexAddress, DXGI_FORMAT indexFormat, UINT indexCount)
+{
+	CreateVertexBuffer(d3DDevice, commandList, vertices, vertexCount, vertexStride);
 
-	mGPUIndexBuffer = CreateDefaultBuffer(mIndices.data(), iBSize, mIndexBufferUploader, d3DDevice, commandList);
+	// Use the shared index buffer
+	UINT indexSize = indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+	mSharedIndexAddress = sharedIndexAddress;
+	mIndexFormat = indexFormat;
+	mIndicesCount = indexCount;
+	mIndexBufferByteSize = indexCount * indexSize;
+}
 
-	mVertexByteStride = sizeof(Vertex);
+void Mesh::CreateVertexBuffer(ID3D12Device* d3DDevice, ID3D12GraphicsCommandList* commandList,
+							const void* vertices, UINT vertexCount, UINT vertexStride)
+{
+	const UINT vBSize = vertexCount * vertexStride;
+
+	// Create CPU buffer
+	D3DCreateBlob(vBSize, &mCPUVertexBuffer);
+	CopyMemory(mCPUVertexBuffer->GetBufferPointer(), vertices, vBSize);
+
+	// Place GPU buffer in the mesh buffer heap
+	MeshBufferHeap->Free(mVertexAllocation);
+	mVertexAllocation = MeshBufferHeap->Upload(commandList, vertices, vBSize);
+	if (!mVertexAllocation.IsValid()) throw std::runtime_error("Failed to allocate mesh vertex buffer");
+
+	mVertexByteStride = vertexStride;
 	mVertexBufferByteSize = vBSize;
-	mIndexBufferByteSize = iBSize;
 }
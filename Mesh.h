@@ -6,6 +6,7 @@
 #include "d3dx12.h"
 #include <DirectXMath.h>
 #include "Utility.h"
+#include "GpuBufferHeap.h"
 #include <vector>
 #include <array>
 #include <D3DCompiler.h>
@@ -23,13 +24,16 @@ public:
 	ComPtr<ID3DBlob> mCPUVertexBuffer = nullptr;
 	ComPtr<ID3DBlob> mCPUIndexBuffer = nullptr;
 
-	// Vertex and index buffers on GPU side
+	// Vertex and index buffers on GPU side, for meshes drawn from buffers outside the mesh buffer heap
 	ComPtr<ID3D12Resource> mGPUVertexBuffer = nullptr;
 	ComPtr<ID3D12Resource> mGPUIndexBuffer = nullptr;
 
-	// Vertex and index buffer uploaders
-	ComPtr<ID3D12Resource> mVertexBufferUploader = nullptr;
-	ComPtr<ID3D12Resource> mIndexBufferUploader = nullptr;
+	// Space for the vertex and index buffers in the mesh buffer heap, given back when the mesh is deleted
+	GpuBufferHeap::Allocation mVertexAllocation;
+	GpuBufferHeap::Allocation mIndexAllocation;
+
+	// Index buffer owned elsewhere in the mesh buffer heap, shared between meshes
+	D3D12_GPU_VIRTUAL_ADDRESS mSharedIndexAddress = 0;
 
 	// Data about buffers.
 	UINT mVertexByteStride = 0;
@@ -38,6 +42,15 @@ public:
 	UINT mIndexBufferByteSize = 0;
 	int  mIndicesCount = 0;
 
+	// Index buffer split into pages, each drawn separately with the same vertex buffer.
+	// Used instead of the index buffer above when not empty
+	struct IndexPage
+	{
+		D3D12_GPU_VIRTUAL_ADDRESS Address;
+		UINT Count;
+	};
+	std::vector<IndexPage> mIndexPages;
+
 	// Geometry
 	std::vector<Vertex> mVertices;
 	std::vector<uint32_t> mIndices;
@@ -48,13 +61,25 @@ public:
 	
 	D3D12_VERTEX_BUFFER_VIEW GetVertexBufferView();
 	D3D12_INDEX_BUFFER_VIEW GetIndexBufferView();
-	void EmptyUploaders();
 
 	// Calculate buffer data for geometry
 	void CalculateBufferData(ID3D12Device* d3DDevice, ID3D12GraphicsCommandList* commandList);
 
+	// Calculate vertex buffer data from vertices of any layout, leaving mVertices empty, and draw
+	// with an index buffer shared between meshes
+	void CalculateBufferData(ID3D12Device* d3DDevice, ID3D12GraphicsCommandList* commandList,
+								const void* vertices, UINT vertexCount, UINT vertexStride,
+								D3D12_GPU_VIRTUAL_ADDRESS sharedIndexAddress, DXGI_FORMAT indexFormat, UINT indexCount);
+
 	// Calculates buffer data for if being used in dynamic vertex + index buffers
 	void CalculateDynamicBufferData();
 
+	// As above for geometry kept outside the mesh, written straight into the dynamic buffers
+	void CalculateDynamicBufferData(UINT vertexCount, UINT indexCount);
+
 	void Draw(ID3D12GraphicsCommandList* commandList);
+private:
+	// Create CPU and GPU vertex buffers
+	void CreateVertexBuffer(ID3D12Device* d3DDevice, ID3D12GraphicsCommandList* commandList,
+							const void* vertices, UINT vertexCount, UINT vertexStride);
 };
@@ -53,6 +53,12 @@ Model::Model(std::string fileName, ID3D12GraphicsCommandList* commandList, Mesh*
 				mTextured = true;
 			}
 		}
+
+		// Bound every mesh
+		for (auto& mesh : mMeshes)
+		{
+			CalculateBoundingRadius(mesh);
+		}
 		
 		// Calculate buffer data for meshes
 		for (auto& mesh : mMeshes)
@@ -64,6 +70,7 @@ Model::Model(std::string fileName, ID3D12GraphicsCommandList* commandList, Mesh*
 	{
 		// Use mesh from constructor
 		mConstructorMesh = mesh;
+		CalculateBoundingRadius(mesh);
 	}
 }
 
@@ -146,6 +153,25 @@ void Model::SetScale(XMFLOAT3 scale, bool update)
 	if (update) UpdateWorldMatrix();
 }
 
+float Model::GetBoundingRadius()
+{
+	// Rotation does not change a sphere around the origin, so only the largest scale matters
+	float scale = mScale.x;
+	if (mScale.y > scale) scale = mScale.y;
+	if (mScale.z > scale) scale = mScale.z;
+	return mBoundingRadius * scale;
+}
+
+void Model::CalculateBoundingRadius(Mesh* mesh)
+{
+	// Grow bounds to contain every vertex
+	for (auto& vertex : mesh->mVertices)
+	{
+		auto length = Distance(vertex.Pos, XMFLOAT3{ 0,0,0 });
+		if (length > mBoundingRadius) mBoundingRadius = length;
+	}
+}
+
 void Model::ProcessNode(aiNode* node, const aiScene* scene)
 {
 	// Process each mesh
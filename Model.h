@@ -23,6 +23,13 @@ public:
 	XMFLOAT3 mScale = XMFLOAT3{ 0,0,0 };
 	XMFLOAT4X4 mWorldMatrix = MakeIdentity4x4();
 
+	// Radius around the origin containing every vertex, before scaling. Meshes that keep their
+	// vertices elsewhere, like the planet's, have it set by their owner
+	float mBoundingRadius = 0;
+
+	// Get bounding radius with scale applied
+	float GetBoundingRadius();
+
 	// Draw each mesh in the model
 	void Draw(ID3D12GraphicsCommandList* commandList);
 
@@ -41,6 +48,7 @@ public:
 	bool mPerMeshTextured = false;
 	bool mParallax = true;
 private:
+	void CalculateBoundingRadius(Mesh* mesh);
 	void ProcessNode(aiNode* node, const aiScene* scene);
 	Mesh* ProcessMesh(aiMesh* mesh, const aiScene* scene);
 	vector<Texture*> LoadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName, const aiScene* scene);
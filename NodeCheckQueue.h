@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Nodes waiting to have their split or merge checked, ordered by the camera travel at which
+// the check is due. A node is only checked once the camera has moved far enough that its
+// distance could have crossed the threshold, so a still camera checks nothing.
+// Only handles and travel distances are used, so it can be driven without a planet.
+template <typename Handle>
+class NodeCheckQueue
+{
+public:
+	// Queue a check for a node once the camera has travelled this far, replacing any already queued
+	void Push(Handle node, double travel)
+	{
+		if (node >= mVersions.size()) mVersions.resize(node + 1, 0);
+		mVersions[node]++;
+		mChecks.push_back({ node, mVersions[node], travel });
+		std::push_heap(mChecks.begin(), mChecks.end());
+	}
+
+	// Take every check due by this travel, skipping replaced ones. Checks queued while handling them
+	// wait for the next call, so a node sitting on its threshold is not checked over and over
+	void PopDue(double travel, std::vector<Handle>& nodes)
+	{
+		nodes.clear();
+		while (!mChecks.empty() && mChecks.front().Travel <= travel)
+		{
+			std::pop_heap(mChecks.begin(), mChecks.end());
+			auto check = mChecks.back();
+			mChecks.pop_back();
+			if (mVersions[check.Node] == check.Version) nodes.push_back(check.Node);
+		}
+	}
+
+	void Clear()
+	{
+		mChecks.clear();
+		mVersions.clear();
+	}
+
+	size_t Size() const { return mChecks.size(); }
+
+private:
+	struct NodeCheck
+	{
+		Handle Node;
+		std::uint32_t Version;
+		double Travel;
+		bool operator<(const NodeCheck& other) const { return Travel > other.Travel; }
+	};
+	std::vector<NodeCheck> mChecks;
+
+	// Version of each node's latest check, kept when a node is released and reused
+	std::vector<std::uint32_t> mVersions;
+};
@@ -0,0 +1,133 @@
+#include "NodePool.h"
+
+void NodePool::Reset(int numBaseNodes, int reserveNodes)
+{
+	// Clear old nodes
+	mTriangle.clear();
+	mParent.clear();
+	mFirstChild.clear();
+	mError.clear();
+	mBoundCentre.clear();
+	mBoundRadius.clear();
+	mMaxRadius.clear();
+	mVisible.clear();
+	mLevel.clear();
+	mTriangleChunk.clear();
+	mFreeBlocks.clear();
+
+	// Reserve memory
+	mTriangle.reserve(reserveNodes);
+	mParent.reserve(reserveNodes);
+	mFirstChild.reserve(reserveNodes);
+	mError.reserve(reserveNodes);
+	mBoundCentre.reserve(reserveNodes);
+	mBoundRadius.reserve(reserveNodes);
+	mMaxRadius.reserve(reserveNodes);
+	mVisible.reserve(reserveNodes);
+	mLevel.reserve(reserveNodes);
+	mTriangleChunk.reserve(reserveNodes);
+
+	// Create base nodes with no parent
+	mNumBaseNodes = numBaseNodes;
+	for (int i = 0; i < numBaseNodes; i++)
+	{
+		PushNode(INVALID_NODE);
+	}
+}
+
+NodeHandle NodePool::PushNode(NodeHandle parent)
+{
+	mTriangle.push_back({ 0,0,0 });
+	mParent.push_back(parent);
+	mFirstChild.push_back(INVALID_NODE);
+	mError.push_back(0);
+	mBoundCentre.push_back({ 0,0,0 });
+	mBoundRadius.push_back(0);
+	mMaxRadius.push_back(0);
+	mVisible.push_back(NODE_VISIBLE);
+	mLevel.push_back(0);
+	mTriangleChunk.push_back(nullptr);
+	return NodeHandle(mParent.size() - 1);
+}
+
+NodeHandle NodePool::AddChildren(NodeHandle parent)
+{
+	NodeHandle first;
+
+	// Reuse a released block if there is one
+	if (!mFreeBlocks.empty())
+	{
+		first = mFreeBlocks.back();
+		mFreeBlocks.pop_back();
+		for (NodeHandle child = first; child < first + NODE_CHILDREN; child++)
+		{
+			mParent[child] = parent;
+			mFirstChild[child] = INVALID_NODE;
+			mError[child] = 0;
+			mBoundCentre[child] = { 0,0,0 };
+			mBoundRadius[child] = 0;
+			mMaxRadius[child] = 0;
+			mVisible[child] = NODE_VISIBLE;
+			mLevel[child] = 0;
+			mTriangleChunk[child] = nullptr;
+		}
+	}
+	else
+	{
+		// Append a new block
+		first = PushNode(parent);
+		for (int i = 1; i < NODE_CHILDREN; i++) PushNode(parent);
+	}
+
+	mFirstChild[parent] = first;
+	return first;
+}
+
+std::uint64_t NodePool::GetPath(NodeHandle node) const
+{
+	// Two bits for the child index at each level, from the bottom up
+	std::uint64_t path = 0;
+	int shift = 0;
+	while (mParent[node] != INVALID_NODE)
+	{
+		auto parent = mParent[node];
+		path |= std::uint64_t(node - mFirstChild[parent]) << shift;
+		shift += 2;
+		node = parent;
+	}
+
+	// Then the base node, with a marker bit above it so paths of different lengths differ
+	return path | (std::uint64_t(node | 0x100) << shift);
+}
+
+void NodePool::RemoveChildren(NodeHandle node, std::vector<TriangleChunk*>& removedChunks, std::vector<Triangle>& splitTriangles)
+{
+	if (IsLeaf(node)) return;
+
+	// Walk the subtree, releasing each child block
+	mStack.clear();
+	mStack.push_back(node);
+	while (!mStack.empty())
+	{
+		NodeHandle current = mStack.back();
+		mStack.pop_back();
+
+		NodeHandle first = mFirstChild[current];
+		if (first == INVALID_NODE) continue;
+		splitTriangles.push_back(mTriangle[current]);
+
+		for (NodeHandle child = first; child < first + NODE_CHILDREN; child++)
+		{
+			if (mTriangleChunk[child])
+			{
+				removedChunks.push_back(mTriangleChunk[child]);
+				mTriangleChunk[child] = nullptr;
+			}
+			mParent[child] = INVALID_NODE;
+			mStack.push_back(child);
+		}
+
+		mFirstChild[current] = INVALID_NODE;
+		mFreeBlocks.push_back(first);
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Utility.h"
+#include <vector>
+#include <cstdint>
+
+class TriangleChunk;
+
+// Index of a node in the pool
+typedef std::uint32_t NodeHandle;
+const NodeHandle INVALID_NODE = UINT32_MAX;
+
+// Every subdivided node has exactly four children
+const int NODE_CHILDREN = 4;
+
+// Result of the last visibility test of a node
+enum NodeVisibility : std::uint8_t
+{
+	NODE_CULLED = 0,
+	NODE_VISIBLE = 1,
+	NODE_INSIDE = 2 // Wholly inside the frustum, so children skip the frustum test
+};
+
+// Quadtree storage for the planet. Node data is kept in parallel arrays indexed by handle,
+// children are allocated in contiguous blocks of four, and blocks released by a merge
+// are reused through a free list so a steady state LOD evaluation makes no allocations.
+class NodePool
+{
+public:
+	// Clear the pool and create the base nodes, which use handles 0 to numBaseNodes - 1
+	void Reset(int numBaseNodes, int reserveNodes = 0);
+
+	// Allocate four children for a leaf node and return the handle of the first one
+	NodeHandle AddChildren(NodeHandle parent);
+
+	// Release the children of a node and everything below them. Chunks owned by the
+	// released nodes are appended to removedChunks, and the triangles of every node that
+	// had its children released are appended to splitTriangles
+	void RemoveChildren(NodeHandle node, std::vector<TriangleChunk*>& removedChunks, std::vector<Triangle>& splitTriangles);
+
+	bool IsLeaf(NodeHandle node) const { return mFirstChild[node] == INVALID_NODE; }
+
+	// Is the node part of the tree, released nodes have no parent
+	bool IsInUse(NodeHandle node) const { return node < NodeHandle(mNumBaseNodes) || mParent[node] != INVALID_NODE; }
+
+	// Get a node's path from its base node, which stays the same however its handle was allocated
+	std::uint64_t GetPath(NodeHandle node) const;
+
+	// Get the base node at the root of a node's tree
+	NodeHandle GetBaseNode(NodeHandle node) const
+	{
+		while (mParent[node] != INVALID_NODE) node = mParent[node];
+		return node;
+	}
+	int NumBaseNodes() const { return mNumBaseNodes; }
+
+	// Number of nodes in use
+	int NumNodes() const { return int(mParent.size()) - int(mFreeBlocks.size()) * NODE_CHILDREN; }
+
+	// Node data, indexed by handle
+	std::vector<Triangle> mTriangle;
+	std::vector<NodeHandle> mParent;
+	std::vector<NodeHandle> mFirstChild;
+
+	// Geometric error of drawing the node as a flat triangle
+	std::vector<float> mError;
+	std::vector<int> mLevel;
+	std::vector<TriangleChunk*> mTriangleChunk;
+
+	// Bounding sphere of the displaced surface, centred on the flat triangle's centre
+	std::vector<XMFLOAT3> mBoundCentre;
+	std::vector<float> mBoundRadius;
+
+	// Furthest distance of the node's surface from the planet centre, for horizon culling
+	std::vector<float> mMaxRadius;
+
+	// NodeVisibility from the last cull
+	std::vector<std::uint8_t> mVisible;
+
+private:
+	// Append a node to the arrays and return its handle
+	NodeHandle PushNode(NodeHandle parent);
+
+	// First handles of released child blocks
+	std::vector<NodeHandle> mFreeBlocks;
+
+	// Scratch stack for iterative traversal
+	std::vector<NodeHandle> mStack;
+
+	int mNumBaseNodes = 0;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "UploadBuffer.h"
+#include <memory>
+#include <span>
+#include <vector>
+
+// Upload buffer made of fixed size pages, so it can grow and shrink without a limit set up front.
+// Pages are allocated as the data grows and released once the data no longer reaches them. Each page
+// is its own resource, so data spanning pages is drawn a page at a time
+template <typename T>
+class PagedUploadBuffer
+{
+public:
+	PagedUploadBuffer(ID3D12Device* device, UINT pageElements) : mDevice(device), mPageElements(pageElements) {}
+
+	// Allocate or release pages to hold elementCount elements. New pages are marked dirty.
+	// The GPU must not be reading the buffer
+	void Resize(UINT elementCount)
+	{
+		auto numPages = (elementCount + mPageElements - 1) / mPageElements;
+		while (mPages.size() > numPages) mPages.pop_back();
+		while (mPages.size() < numPages)
+		{
+			mPages.push_back(std::make_unique<UploadBuffer<T>>(mDevice, mPageElements, false));
+			mPages.back()->MarkAllDirty();
+		}
+		mElementCount = elementCount;
+	}
+
+	// Queue elements to copy at the next Flush, split between the pages they fall in
+	void MarkDirty(const DirtyIntervals& intervals)
+	{
+		for (auto& interval : intervals.Intervals())
+		{
+			auto first = interval.First;
+			auto last = interval.First + interval.Count;
+			while (first < last && first / mPageElements < mPages.size())
+			{
+				auto page = first / mPageElements;
+				auto pageEnd = (page + 1) * mPageElements;
+				auto end = last < pageEnd ? last : pageEnd;
+				mPages[page]->MarkDirty(first - page * mPageElements, end - first);
+				first = end;
+			}
+		}
+	}
+
+	void MarkAllDirty()
+	{
+		for (auto& page : mPages) page->MarkAllDirty();
+	}
+
+	// Fit the pages to source, then copy the queued ranges from it
+	void Flush(std::span<const T> source)
+	{
+		Resize(UINT(source.size()));
+		for (size_t page = 0; page < mPages.size(); page++)
+		{
+			mPages[page]->Flush(source.subspan(page * mPageElements));
+		}
+	}
+
+	size_t NumPages() const { return mPages.size(); }
+	UploadBuffer<T>* GetPage(size_t page) { return mPages[page].get(); }
+
+	// Elements of data held by a page, the last page may be partly used
+	UINT PageCount(size_t page) const
+	{
+		auto first = UINT(page) * mPageElements;
+		return mElementCount - first < mPageElements ? mElementCount - first : mPageElements;
+	}
+
+	UINT PageElements() const { return mPageElements; }
+	size_t SizeInBytes() const { return mPages.size() * mPageElements * sizeof(T); }
+
+private:
+	ID3D12Device* mDevice;
+	UINT mPageElements;
+	UINT mElementCount = 0;
+	std::vector<std::unique_ptr<UploadBuffer<T>>> mPages;
+};
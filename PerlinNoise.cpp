@@ -0,0 +1,732 @@
+#include "PerlinNoise.h"
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PERLIN_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	// Hash primes, multiplier, output scale and gradients of FastNoiseLite's 3D Perlin noise
+	const int PRIME_X = 501125321;
+	const int PRIME_Y = 1136930381;
+	const int PRIME_Z = 1720413743;
+	const int HASH_MULTIPLIER = 0x27d4eb2d;
+	const float PERLIN_SCALE = 0.964921414852142333984375f;
+
+	alignas(32) const float GRADIENTS[256] =
+	{
+		0, 1, 1, 0,  0,-1, 1, 0,  0, 1,-1, 0,  0,-1,-1, 0,
+		1, 0, 1, 0, -1, 0, 1, 0,  1, 0,-1, 0, -1, 0,-1, 0,
+		1, 1, 0, 0, -1, 1, 0, 0,  1,-1, 0, 0, -1,-1, 0, 0,
+		0, 1, 1, 0,  0,-1, 1, 0,  0, 1,-1, 0,  0,-1,-1, 0,
+		1, 0, 1, 0, -1, 0, 1, 0,  1, 0,-1, 0, -1, 0,-1, 0,
+		1, 1, 0, 0, -1, 1, 0, 0,  1,-1, 0, 0, -1,-1, 0, 0,
+		0, 1, 1, 0,  0,-1, 1, 0,  0, 1,-1, 0,  0,-1,-1, 0,
+		1, 0, 1, 0, -1, 0, 1, 0,  1, 0,-1, 0, -1, 0,-1, 0,
+		1, 1, 0, 0, -1, 1, 0, 0,  1,-1, 0, 0, -1,-1, 0, 0,
+		0, 1, 1, 0,  0,-1, 1, 0,  0, 1,-1, 0,  0,-1,-1, 0,
+		1, 0, 1, 0, -1, 0, 1, 0,  1, 0,-1, 0, -1, 0,-1, 0,
+		1, 1, 0, 0, -1, 1, 0, 0,  1,-1, 0, 0, -1,-1, 0, 0,
+		0, 1, 1, 0,  0,-1, 1, 0,  0, 1,-1, 0,  0,-1,-1, 0,
+		1, 0, 1, 0, -1, 0, 1, 0,  1, 0,-1, 0, -1, 0,-1, 0,
+		1, 1, 0, 0, -1, 1, 0, 0,  1,-1, 0, 0, -1,-1, 0, 0,
+		1, 1, 0, 0,  0,-1, 1, 0, -1, 1, 0, 0,  0,-1,-1, 0
+	};
+
+	// Integer maths wraps like FastNoiseLite's, done unsigned to keep it defined
+	int MulWrap(int a, int b) { return int(std::uint32_t(a) * std::uint32_t(b)); }
+
+	int FastFloor(float f) { return f >= 0 ? int(f) : int(f) - 1; }
+	float Lerp(float a, float b, float t) { return a + t * (b - a); }
+	float InterpQuintic(float t) { return t * t * t * (t * (t * 6 - 15) + 10); }
+
+	float GradCoord(int seed, int xPrimed, int yPrimed, int zPrimed, float xd, float yd, float zd)
+	{
+		int hash = MulWrap(seed ^ xPrimed ^ yPrimed ^ zPrimed, HASH_MULTIPLIER);
+		hash ^= hash >> 15;
+		hash &= 63 << 2;
+		return xd * GRADIENTS[hash] + yd * GRADIENTS[hash | 1] + zd * GRADIENTS[hash | 2];
+	}
+
+	float Perlin(int seed, float x, float y, float z)
+	{
+		int x0 = FastFloor(x);
+		int y0 = FastFloor(y);
+		int z0 = FastFloor(z);
+
+		float xd0 = x - float(x0);
+		float yd0 = y - float(y0);
+		float zd0 = z - float(z0);
+		float xd1 = xd0 - 1;
+		float yd1 = yd0 - 1;
+		float zd1 = zd0 - 1;
+
+		float xs = InterpQuintic(xd0);
+		float ys = InterpQuintic(yd0);
+		float zs = InterpQuintic(zd0);
+
+		x0 = MulWrap(x0, PRIME_X);
+		y0 = MulWrap(y0, PRIME_Y);
+		z0 = MulWrap(z0, PRIME_Z);
+		int x1 = int(std::uint32_t(x0) + PRIME_X);
+		int y1 = int(std::uint32_t(y0) + PRIME_Y);
+		int z1 = int(std::uint32_t(z0) + PRIME_Z);
+
+		float xf00 = Lerp(GradCoord(seed, x0, y0, z0, xd0, yd0, zd0), GradCoord(seed, x1, y0, z0, xd1, yd0, zd0), xs);
+		float xf10 = Lerp(GradCoord(seed, x0, y1, z0, xd0, yd1, zd0), GradCoord(seed, x1, y1, z0, xd1, yd1, zd0), xs);
+		float xf01 = Lerp(GradCoord(seed, x0, y0, z1, xd0, yd0, zd1), GradCoord(seed, x1, y0, z1, xd1, yd0, zd1), xs);
+		float xf11 = Lerp(GradCoord(seed, x0, y1, z1, xd0, yd1, zd1), GradCoord(seed, x1, y1, z1, xd1, yd1, zd1), xs);
+
+		float yf0 = Lerp(xf00, xf10, ys);
+		float yf1 = Lerp(xf01, xf11, ys);
+
+		return Lerp(yf0, yf1, zs) * PERLIN_SCALE;
+	}
+
+	float InterpQuinticDerivative(float t) { return 30 * t * t * (t * (t - 2) + 1); }
+
+	// Interpolate values at the corners of a cell, corner bits are x, y then z
+	float Trilerp(const float* corner, float xs, float ys, float zs)
+	{
+		return Lerp(Lerp(Lerp(corner[0], corner[1], xs), Lerp(corner[2], corner[3], xs), ys),
+			Lerp(Lerp(corner[4], corner[5], xs), Lerp(corner[6], corner[7], xs), ys), zs);
+	}
+
+	// Perlin noise and its gradient. The value is the same as Perlin's
+	float PerlinGradient(int seed, float x, float y, float z, float& dx, float& dy, float& dz)
+	{
+		int x0 = FastFloor(x);
+		int y0 = FastFloor(y);
+		int z0 = FastFloor(z);
+
+		float xd[2] = { x - float(x0), 0 };
+		float yd[2] = { y - float(y0), 0 };
+		float zd[2] = { z - float(z0), 0 };
+		xd[1] = xd[0] - 1;
+		yd[1] = yd[0] - 1;
+		zd[1] = zd[0] - 1;
+
+		float xs = InterpQuintic(xd[0]);
+		float ys = InterpQuintic(yd[0]);
+		float zs = InterpQuintic(zd[0]);
+
+		int xPrimed[2] = { MulWrap(x0, PRIME_X), 0 };
+		int yPrimed[2] = { MulWrap(y0, PRIME_Y), 0 };
+		int zPrimed[2] = { MulWrap(z0, PRIME_Z), 0 };
+		xPrimed[1] = int(std::uint32_t(xPrimed[0]) + PRIME_X);
+		yPrimed[1] = int(std::uint32_t(yPrimed[0]) + PRIME_Y);
+		zPrimed[1] = int(std::uint32_t(zPrimed[0]) + PRIME_Z);
+
+		// Gradient and its dot product with the offset at each corner
+		float value[8], xg[8], yg[8], zg[8];
+		for (int corner = 0; corner < 8; corner++)
+		{
+			int i = corner & 1;
+			int j = (corner >> 1) & 1;
+			int k = corner >> 2;
+			int hash = MulWrap(seed ^ xPrimed[i] ^ yPrimed[j] ^ zPrimed[k], HASH_MULTIPLIER);
+			hash ^= hash >> 15;
+			hash &= 63 << 2;
+			xg[corner] = GRADIENTS[hash];
+			yg[corner] = GRADIENTS[hash | 1];
+			zg[corner] = GRADIENTS[hash | 2];
+			value[corner] = xd[i] * xg[corner] + yd[j] * yg[corner] + zd[k] * zg[corner];
+		}
+
+		float xf00 = Lerp(value[0], value[1], xs);
+		float xf10 = Lerp(value[2], value[3], xs);
+		float xf01 = Lerp(value[4], value[5], xs);
+		float xf11 = Lerp(value[6], value[7], xs);
+		float yf0 = Lerp(xf00, xf10, ys);
+		float yf1 = Lerp(xf01, xf11, ys);
+
+		// Change in the interpolation weights plus the interpolated corner gradients
+		float xChange = Lerp(Lerp(value[1] - value[0], value[3] - value[2], ys), Lerp(value[5] - value[4], value[7] - value[6], ys), zs);
+		dx = (InterpQuinticDerivative(xd[0]) * xChange + Trilerp(xg, xs, ys, zs)) * PERLIN_SCALE;
+		dy = (InterpQuinticDerivative(yd[0]) * Lerp(xf10 - xf00, xf11 - xf01, zs) + Trilerp(yg, xs, ys, zs)) * PERLIN_SCALE;
+		dz = (InterpQuinticDerivative(zd[0]) * (yf1 - yf0) + Trilerp(zg, xs, ys, zs)) * PERLIN_SCALE;
+
+		return Lerp(yf0, yf1, zs) * PERLIN_SCALE;
+	}
+
+	// Positions from first to count, one at a time
+	void FractalBrownianMotionScalar(int seed, const float* x, const float* y, const float* z, float* result,
+		size_t first, size_t count, int octaves, float frequency, float amplitude)
+	{
+		for (size_t i = first; i < count; i++)
+		{
+			float value = 0;
+			float octaveAmplitude = amplitude;
+			float octaveFrequency = frequency;
+			for (int octave = 0; octave < octaves; octave++)
+			{
+				value += octaveAmplitude * Perlin(seed, (octaveFrequency * x[i]) * NOISE_FREQUENCY,
+					(octaveFrequency * y[i]) * NOISE_FREQUENCY, (octaveFrequency * z[i]) * NOISE_FREQUENCY);
+				octaveFrequency *= 2.0f;
+				octaveAmplitude *= 0.5f;
+			}
+			result[i] = value;
+		}
+	}
+
+	void FractalBrownianMotionGradientScalar(int seed, const float* x, const float* y, const float* z, float* result,
+		float* gradientX, float* gradientY, float* gradientZ, size_t first, size_t count, int octaves, float frequency, float amplitude)
+	{
+		for (size_t i = first; i < count; i++)
+		{
+			float value = 0;
+			float gx = 0;
+			float gy = 0;
+			float gz = 0;
+			float octaveAmplitude = amplitude;
+			float octaveFrequency = frequency;
+			for (int octave = 0; octave < octaves; octave++)
+			{
+				float dx, dy, dz;
+				value += octaveAmplitude * PerlinGradient(seed, (octaveFrequency * x[i]) * NOISE_FREQUENCY,
+					(octaveFrequency * y[i]) * NOISE_FREQUENCY, (octaveFrequency * z[i]) * NOISE_FREQUENCY, dx, dy, dz);
+
+				// Chain rule through the scale of the octave's input
+				float scale = octaveAmplitude * octaveFrequency * NOISE_FREQUENCY;
+				gx += scale * dx;
+				gy += scale * dy;
+				gz += scale * dz;
+
+				octaveFrequency *= 2.0f;
+				octaveAmplitude *= 0.5f;
+			}
+			result[i] = value;
+			gradientX[i] = gx;
+			gradientY[i] = gy;
+			gradientZ[i] = gz;
+		}
+	}
+
+#ifdef PERLIN_SIMD
+	// SSE2 has no 32 bit multiply, so multiply the even and odd lanes separately and interleave them
+	__m128i MulWrap4(__m128i a, __m128i b)
+	{
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	// Same rounding as FastFloor, truncate then step down for negative values
+	__m128i FastFloor4(__m128 f)
+	{
+		return _mm_add_epi32(_mm_cvttps_epi32(f), _mm_castps_si128(_mm_cmplt_ps(f, _mm_setzero_ps())));
+	}
+
+	__m128 Lerp4(__m128 a, __m128 b, __m128 t) { return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a))); }
+
+	__m128 InterpQuintic4(__m128 t)
+	{
+		__m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6)), _mm_set1_ps(15))), _mm_set1_ps(10));
+		return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+	}
+
+	// No gather in SSE2, look the gradients up one lane at a time
+	void LookupGradients4(__m128i hash, __m128& xg, __m128& yg, __m128& zg)
+	{
+		alignas(16) std::int32_t index[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(index), hash);
+		xg = _mm_setr_ps(GRADIENTS[index[0]], GRADIENTS[index[1]], GRADIENTS[index[2]], GRADIENTS[index[3]]);
+		yg = _mm_setr_ps(GRADIENTS[index[0] | 1], GRADIENTS[index[1] | 1], GRADIENTS[index[2] | 1], GRADIENTS[index[3] | 1]);
+		zg = _mm_setr_ps(GRADIENTS[index[0] | 2], GRADIENTS[index[1] | 2], GRADIENTS[index[2] | 2], GRADIENTS[index[3] | 2]);
+	}
+
+	__m128 GradCoord4(__m128i seed, __m128i xPrimed, __m128i yPrimed, __m128i zPrimed, __m128 xd, __m128 yd, __m128 zd)
+	{
+		__m128i hash = MulWrap4(_mm_xor_si128(_mm_xor_si128(seed, xPrimed), _mm_xor_si128(yPrimed, zPrimed)), _mm_set1_epi32(HASH_MULTIPLIER));
+		hash = _mm_xor_si128(hash, _mm_srai_epi32(hash, 15));
+		hash = _mm_and_si128(hash, _mm_set1_epi32(63 << 2));
+
+		__m128 xg, yg, zg;
+		LookupGradients4(hash, xg, yg, zg);
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(xd, xg), _mm_mul_ps(yd, yg)), _mm_mul_ps(zd, zg));
+	}
+
+	__m128 Perlin4(__m128i seed, __m128 x, __m128 y, __m128 z)
+	{
+		__m128i x0 = FastFloor4(x);
+		__m128i y0 = FastFloor4(y);
+		__m128i z0 = FastFloor4(z);
+
+		__m128 one = _mm_set1_ps(1);
+		__m128 xd0 = _mm_sub_ps(x, _mm_cvtepi32_ps(x0));
+		__m128 yd0 = _mm_sub_ps(y, _mm_cvtepi32_ps(y0));
+		__m128 zd0 = _mm_sub_ps(z, _mm_cvtepi32_ps(z0));
+		__m128 xd1 = _mm_sub_ps(xd0, one);
+		__m128 yd1 = _mm_sub_ps(yd0, one);
+		__m128 zd1 = _mm_sub_ps(zd0, one);
+
+		__m128 xs = InterpQuintic4(xd0);
+		__m128 ys = InterpQuintic4(yd0);
+		__m128 zs = InterpQuintic4(zd0);
+
+		x0 = MulWrap4(x0, _mm_set1_epi32(PRIME_X));
+		y0 = MulWrap4(y0, _mm_set1_epi32(PRIME_Y));
+		z0 = MulWrap4(z0, _mm_set1_epi32(PRIME_Z));
+		__m128i x1 = _mm_add_epi32(x0, _mm_set1_epi32(PRIME_X));
+		__m128i y1 = _mm_add_epi32(y0, _mm_set1_epi32(PRIME_Y));
+		__m128i z1 = _mm_add_epi32(z0, _mm_set1_epi32(PRIME_Z));
+
+		__m128 xf00 = Lerp4(GradCoord4(seed, x0, y0, z0, xd0, yd0, zd0), GradCoord4(seed, x1, y0, z0, xd1, yd0, zd0), xs);
+		__m128 xf10 = Lerp4(GradCoord4(seed, x0, y1, z0, xd0, yd1, zd0), GradCoord4(seed, x1, y1, z0, xd1, yd1, zd0), xs);
+		__m128 xf01 = Lerp4(GradCoord4(seed, x0, y0, z1, xd0, yd0, zd1), GradCoord4(seed, x1, y0, z1, xd1, yd0, zd1), xs);
+		__m128 xf11 = Lerp4(GradCoord4(seed, x0, y1, z1, xd0, yd1, zd1), GradCoord4(seed, x1, y1, z1, xd1, yd1, zd1), xs);
+
+		__m128 yf0 = Lerp4(xf00, xf10, ys);
+		__m128 yf1 = Lerp4(xf01, xf11, ys);
+
+		return _mm_mul_ps(Lerp4(yf0, yf1, zs), _mm_set1_ps(PERLIN_SCALE));
+	}
+
+	// Whole blocks of 4 positions, returning the number done
+	size_t FractalBrownianMotionSSE2(int seed, const float* x, const float* y, const float* z, float* result,
+		size_t count, int octaves, float frequency, float amplitude)
+	{
+		__m128i seed4 = _mm_set1_epi32(seed);
+		__m128 noiseFrequency = _mm_set1_ps(NOISE_FREQUENCY);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 px = _mm_loadu_ps(x + i);
+			__m128 py = _mm_loadu_ps(y + i);
+			__m128 pz = _mm_loadu_ps(z + i);
+
+			__m128 value = _mm_setzero_ps();
+			float octaveAmplitude = amplitude;
+			float octaveFrequency = frequency;
+			for (int octave = 0; octave < octaves; octave++)
+			{
+				__m128 f = _mm_set1_ps(octaveFrequency);
+				__m128 noise = Perlin4(seed4, _mm_mul_ps(_mm_mul_ps(f, px), noiseFrequency),
+					_mm_mul_ps(_mm_mul_ps(f, py), noiseFrequency), _mm_mul_ps(_mm_mul_ps(f, pz), noiseFrequency));
+				value = _mm_add_ps(value, _mm_mul_ps(_mm_set1_ps(octaveAmplitude), noise));
+				octaveFrequency *= 2.0f;
+				octaveAmplitude *= 0.5f;
+			}
+			_mm_storeu_ps(result + i, value);
+		}
+		return i;
+	}
+
+	__m128 InterpQuinticDerivative4(__m128 t)
+	{
+		__m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(t, _mm_set1_ps(2))), _mm_set1_ps(1));
+		return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(30), t), t), inner);
+	}
+
+	__m128 Trilerp4(const __m128* corner, __m128 xs, __m128 ys, __m128 zs)
+	{
+		return Lerp4(Lerp4(Lerp4(corner[0], corner[1], xs), Lerp4(corner[2], corner[3], xs), ys),
+			Lerp4(Lerp4(corner[4], corner[5], xs), Lerp4(corner[6], corner[7], xs), ys), zs);
+	}
+
+	__m128 PerlinGradient4(__m128i seed, __m128 x, __m128 y, __m128 z, __m128& dx, __m128& dy, __m128& dz)
+	{
+		__m128i x0 = FastFloor4(x);
+		__m128i y0 = FastFloor4(y);
+		__m128i z0 = FastFloor4(z);
+
+		__m128 one = _mm_set1_ps(1);
+		__m128 xd[2] = { _mm_sub_ps(x, _mm_cvtepi32_ps(x0)) };
+		__m128 yd[2] = { _mm_sub_ps(y, _mm_cvtepi32_ps(y0)) };
+		__m128 zd[2] = { _mm_sub_ps(z, _mm_cvtepi32_ps(z0)) };
+		xd[1] = _mm_sub_ps(xd[0], one);
+		yd[1] = _mm_sub_ps(yd[0], one);
+		zd[1] = _mm_sub_ps(zd[0], one);
+
+		__m128 xs = InterpQuintic4(xd[0]);
+		__m128 ys = InterpQuintic4(yd[0]);
+		__m128 zs = InterpQuintic4(zd[0]);
+
+		__m128i xPrimed[2] = { MulWrap4(x0, _mm_set1_epi32(PRIME_X)) };
+		__m128i yPrimed[2] = { MulWrap4(y0, _mm_set1_epi32(PRIME_Y)) };
+		__m128i zPrimed[2] = { MulWrap4(z0, _mm_set1_epi32(PRIME_Z)) };
+		xPrimed[1] = _mm_add_epi32(xPrimed[0], _mm_set1_epi32(PRIME_X));
+		yPrimed[1] = _mm_add_epi32(yPrimed[0], _mm_set1_epi32(PRIME_Y));
+		zPrimed[1] = _mm_add_epi32(zPrimed[0], _mm_set1_epi32(PRIME_Z));
+
+		__m128 value[8], xg[8], yg[8], zg[8];
+		for (int corner = 0; corner < 8; corner++)
+		{
+			int i = corner & 1;
+			int j = (corner >> 1) & 1;
+			int k = corner >> 2;
+			__m128i hash = MulWrap4(_mm_xor_si128(_mm_xor_si128(seed, xPrimed[i]), _mm_xor_si128(yPrimed[j], zPrimed[k])), _mm_set1_epi32(HASH_MULTIPLIER));
+			hash = _mm_xor_si128(hash, _mm_srai_epi32(hash, 15));
+			hash = _mm_and_si128(hash, _mm_set1_epi32(63 << 2));
+			LookupGradients4(hash, xg[corner], yg[corner], zg[corner]);
+			value[corner] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xd[i], xg[corner]), _mm_mul_ps(yd[j], yg[corner])), _mm_mul_ps(zd[k], zg[corner]));
+		}
+
+		__m128 xf00 = Lerp4(value[0], value[1], xs);
+		__m128 xf10 = Lerp4(value[2], value[3], xs);
+		__m128 xf01 = Lerp4(value[4], value[5], xs);
+		__m128 xf11 = Lerp4(value[6], value[7], xs);
+		__m128 yf0 = Lerp4(xf00, xf10, ys);
+		__m128 yf1 = Lerp4(xf01, xf11, ys);
+
+		__m128 scale = _mm_set1_ps(PERLIN_SCALE);
+		__m128 xChange = Lerp4(Lerp4(_mm_sub_ps(value[1], value[0]), _mm_sub_ps(value[3], value[2]), ys),
+			Lerp4(_mm_sub_ps(value[5], value[4]), _mm_sub_ps(value[7], value[6]), ys), zs);
+		__m128 yChange = Lerp4(_mm_sub_ps(xf10, xf00), _mm_sub_ps(xf11, xf01), zs);
+		__m128 zChange = _mm_sub_ps(yf1, yf0);
+		dx = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(InterpQuinticDerivative4(xd[0]), xChange), Trilerp4(xg, xs, ys, zs)), scale);
+		dy = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(InterpQuinticDerivative4(yd[0]), yChange), Trilerp4(yg, xs, ys, zs)), scale);
+		dz = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(InterpQuinticDerivative4(zd[0]), zChange), Trilerp4(zg, xs, ys, zs)), scale);
+
+		return _mm_mul_ps(Lerp4(yf0, yf1, zs), scale);
+	}
+
+	size_t FractalBrownianMotionGradientSSE2(int seed, const float* x, const float* y, const float* z, float* result,
+		float* gradientX, float* gradientY, float* gradientZ, size_t count, int octaves, float frequency, float amplitude)
+	{
+		__m128i seed4 = _mm_set1_epi32(seed);
+		__m128 noiseFrequency = _mm_set1_ps(NOISE_FREQUENCY);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 px = _mm_loadu_ps(x + i);
+			__m128 py = _mm_loadu_ps(y + i);
+			__m128 pz = _mm_loadu_ps(z + i);
+
+			__m128 value = _mm_setzero_ps();
+			__m128 gx = _mm_setzero_ps();
+			__m128 gy = _mm_setzero_ps();
+			__m128 gz = _mm_setzero_ps();
+			float octaveAmplitude = amplitude;
+			float octaveFrequency = frequency;
+			for (int octave = 0; octave < octaves; octave++)
+			{
+				__m128 f = _mm_set1_ps(octaveFrequency);
+				__m128 dx, dy, dz;
+				__m128 noise = PerlinGradient4(seed4, _mm_mul_ps(_mm_mul_ps(f, px), noiseFrequency),
+					_mm_mul_ps(_mm_mul_ps(f, py), noiseFrequency), _mm_mul_ps(_mm_mul_ps(f, pz), noiseFrequency), dx, dy, dz);
+				value = _mm_add_ps(value, _mm_mul_ps(_mm_set1_ps(octaveAmplitude), noise));
+
+				__m128 scale = _mm_set1_ps(octaveAmplitude * octaveFrequency * NOISE_FREQUENCY);
+				gx = _mm_add_ps(gx, _mm_mul_ps(scale, dx));
+				gy = _mm_add_ps(gy, _mm_mul_ps(scale, dy));
+				gz = _mm_add_ps(gz, _mm_mul_ps(scale, dz));
+
+				octaveFrequency *= 2.0f;
+				octaveAmplitude *= 0.5f;
+			}
+			_mm_storeu_ps(result + i, value);
+			_mm_storeu_ps(gradientX + i, gx);
+			_mm_storeu_ps(gradientY + i, gy);
+			_mm_storeu_ps(gradientZ + i, gz);
+		}
+		return i;
+	}
+
+	AVX2_FUNCTION __m256i FastFloor8(__m256 f)
+	{
+		return _mm256_add_epi32(_mm256_cvttps_epi32(f), _mm256_castps_si256(_mm256_cmp_ps(f, _mm256_setzero_ps(), _CMP_LT_OQ)));
+	}
+
+	AVX2_FUNCTION __m256 Lerp8(__m256 a, __m256 b, __m256 t) { return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a))); }
+
+	AVX2_FUNCTION __m256 InterpQuintic8(__m256 t)
+	{
+		__m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6)), _mm256_set1_ps(15))), _mm256_set1_ps(10));
+		return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+	}
+
+	AVX2_FUNCTION __m256 GradCoord8(__m256i seed, __m256i xPrimed, __m256i yPrimed, __m256i zPrimed, __m256 xd, __m256 yd, __m256 zd)
+	{
+		__m256i hash = _mm256_mullo_epi32(_mm256_xor_si256(_mm256_xor_si256(seed, xPrimed), _mm256_xor_si256(yPrimed, zPrimed)), _mm256_set1_epi32(HASH_MULTIPLIER));
+		hash = _mm256_xor_si256(hash, _mm256_srai_epi32(hash, 15));
+		hash = _mm256_and_si256(hash, _mm256_set1_epi32(63 << 2));
+
+		__m256 xg = _mm256_i32gather_ps(GRADIENTS, hash, 4);
+		__m256 yg = _mm256_i32gather_ps(GRADIENTS + 1, hash, 4);
+		__m256 zg = _mm256_i32gather_ps(GRADIENTS + 2, hash, 4);
+
+		return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xd, xg), _mm256_mul_ps(yd, yg)), _mm256_mul_ps(zd, zg));
+	}
+
+	AVX2_FUNCTION __m256 Perlin8(__m256i seed, __m256 x, __m256 y, __m256 z)
+	{
+		__m256i x0 = FastFloor8(x);
+		__m256i y0 = FastFloor8(y);
+		__m256i z0 = FastFloor8(z);
+
+		__m256 one = _mm256_set1_ps(1);
+		__m256 xd0 = _mm256_sub_ps(x, _mm256_cvtepi32_ps(x0));
+		__m256 yd0 = _mm256_sub_ps(y, _mm256_cvtepi32_ps(y0));
+		__m256 zd0 = _mm256_sub_ps(z, _mm256_cvtepi32_ps(z0));
+		__m256 xd1 = _mm256_sub_ps(xd0, one);
+		__m256 yd1 = _mm256_sub_ps(yd0, one);
+		__m256 zd1 = _mm256_sub_ps(zd0, one);
+
+		__m256 xs = InterpQuintic8(xd0);
+		__m256 ys = InterpQuintic8(yd0);
+		__m256 zs = InterpQuintic8(zd0);
+
+		x0 = _mm256_mullo_epi32(x0, _mm256_set1_epi32(PRIME_X));
+		y0 = _mm256_mullo_epi32(y0, _mm256_set1_epi32(PRIME_Y));
+		z0 = _mm256_mullo_epi32(z0, _mm256_set1_epi32(PRIME_Z));
+		__m256i x1 = _mm256_add_epi32(x0, _mm256_set1_epi32(PRIME_X));
+		__m256i y1 = _mm256_add_epi32(y0, _mm256_set1_epi32(PRIME_Y));
+		__m256i z1 = _mm256_add_epi32(z0, _mm256_set1_epi32(PRIME_Z));
+
+		__m256 xf00 = Lerp8(GradCoord8(seed, x0, y0, z0, xd0, yd0, zd0), GradCoord8(seed, x1, y0, z0, xd1, yd0, zd0), xs);
+		__m256 xf10 = Lerp8(GradCoord8(seed, x0, y1, z0, xd0, yd1, zd0), GradCoord8(seed, x1, y1, z0, xd1, yd1, zd0), xs);
+		__m256 xf01 = Lerp8(GradCoord8(seed, x0, y0, z1, xd0, yd0, zd1), GradCoord8(seed, x1, y0, z1, xd1, yd0, zd1), xs);
+		__m256 xf11 = Lerp8(GradCoord8(seed, x0, y1, z1, xd0, yd1, zd1), GradCoord8(seed, x1, y1, z1, xd1, yd1, zd1), xs);
+
+		__m256 yf0 = Lerp8(xf00, xf10, ys);
+		__m256 yf1 = Lerp8(xf01, xf11, ys);
+
+		return _mm256_mul_ps(Lerp8(yf0, yf1, zs), _mm256_set1_ps(PERLIN_SCALE));
+	}
+
+	// Whole blocks of 8 positions, returning the number done
+	AVX2_FUNCTION size_t FractalBrownianMotionAVX2(int seed, const float* x, const float* y, const float* z, float* result,
+		size_t count, int octaves, float frequency, float amplitude)
+	{
+		__m256i seed8 = _mm256_set1_epi32(seed);
+		__m256 noiseFrequency = _mm256_set1_ps(NOISE_FREQUENCY);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 px = _mm256_loadu_ps(x + i);
+			__m256 py = _mm256_loadu_ps(y + i);
+			__m256 pz = _mm256_loadu_ps(z + i);
+
+			__m256 value = _mm256_setzero_ps();
+			float octaveAmplitude = amplitude;
+			float octaveFrequency = frequency;
+			for (int octave = 0; octave < octaves; octave++)
+			{
+				__m256 f = _mm256_set1_ps(octaveFrequency);
+				__m256 noise = Perlin8(seed8, _mm256_mul_ps(_mm256_mul_ps(f, px), noiseFrequency),
+					_mm256_mul_ps(_mm256_mul_ps(f, py), noiseFrequency), _mm256_mul_ps(_mm256_mul_ps(f, pz), noiseFrequency));
+				value = _mm256_add_ps(value, _mm256_mul_ps(_mm256_set1_ps(octaveAmplitude), noise));
+				octaveFrequency *= 2.0f;
+				octaveAmplitude *= 0.5f;
+			}
+			_mm256_storeu_ps(result + i, value);
+		}
+
+		// Avoid the penalty of mixing AVX and SSE code in the caller
+		_mm256_zeroupper();
+		return i;
+	}
+
+	AVX2_FUNCTION __m256 InterpQuinticDerivative8(__m256 t)
+	{
+		__m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(t, _mm256_set1_ps(2))), _mm256_set1_ps(1));
+		return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(30), t), t), inner);
+	}
+
+	AVX2_FUNCTION __m256 Trilerp8(const __m256* corner, __m256 xs, __m256 ys, __m256 zs)
+	{
+		return Lerp8(Lerp8(Lerp8(corner[0], corner[1], xs), Lerp8(corner[2], corner[3], xs), ys),
+			Lerp8(Lerp8(corner[4], corner[5], xs), Lerp8(corner[6], corner[7], xs), ys), zs);
+	}
+
+	AVX2_FUNCTION __m256 PerlinGradient8(__m256i seed, __m256 x, __m256 y, __m256 z, __m256& dx, __m256& dy, __m256& dz)
+	{
+		__m256i x0 = FastFloor8(x);
+		__m256i y0 = FastFloor8(y);
+		__m256i z0 = FastFloor8(z);
+
+		__m256 one = _mm256_set1_ps(1);
+		__m256 xd[2] = { _mm256_sub_ps(x, _mm256_cvtepi32_ps(x0)) };
+		__m256 yd[2] = { _mm256_sub_ps(y, _mm256_cvtepi32_ps(y0)) };
+		__m256 zd[2] = { _mm256_sub_ps(z, _mm256_cvtepi32_ps(z0)) };
+		xd[1] = _mm256_sub_ps(xd[0], one);
+		yd[1] = _mm256_sub_ps(yd[0], one);
+		zd[1] = _mm256_sub_ps(zd[0], one);
+
+		__m256 xs = InterpQuintic8(xd[0]);
+		__m256 ys = InterpQuintic8(yd[0]);
+		__m256 zs = InterpQuintic8(zd[0]);
+
+		__m256i xPrimed[2] = { _mm256_mullo_epi32(x0, _mm256_set1_epi32(PRIME_X)) };
+		__m256i yPrimed[2] = { _mm256_mullo_epi32(y0, _mm256_set1_epi32(PRIME_Y)) };
+		__m256i zPrimed[2] = { _mm256_mullo_epi32(z0, _mm256_set1_epi32(PRIME_Z)) };
+		xPrimed[1] = _mm256_add_epi32(xPrimed[0], _mm256_set1_epi32(PRIME_X));
+		yPrimed[1] = _mm256_add_epi32(yPrimed[0], _mm256_set1_epi32(PRIME_Y));
+		zPrimed[1] = _mm256_add_epi32(zPrimed[0], _mm256_set1_epi32(PRIME_Z));
+
+		__m256 value[8], xg[8], yg[8], zg[8];
+		for (int corner = 0; corner < 8; corner++)
+		{
+			int i = corner & 1;
+			int j = (corner >> 1) & 1;
+			int k = corner >> 2;
+			__m256i hash = _mm256_mullo_epi32(_mm256_xor_si256(_mm256_xor_si256(seed, xPrimed[i]), _mm256_xor_si256(yPrimed[j], zPrimed[k])), _mm256_set1_epi32(HASH_MULTIPLIER));
+			hash = _mm256_xor_si256(hash, _mm256_srai_epi32(hash, 15));
+			hash = _mm256_and_si256(hash, _mm256_set1_epi32(63 << 2));
+			xg[corner] = _mm256_i32gather_ps(GRADIENTS, hash, 4);
+			yg[corner] = _mm256_i32gather_ps(GRADIENTS + 1, hash, 4);
+			zg[corner] = _mm256_i32gather_ps(GRADIENTS + 2, hash, 4);
+			value[corner] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xd[i], xg[corner]), _mm256_mul_ps(yd[j], yg[corner])), _mm256_mul_ps(zd[k], zg[corner]));
+		}
+
+		__m256 xf00 = Lerp8(value[0], value[1], xs);
+		__m256 xf10 = Lerp8(value[2], value[3], xs);
+		__m256 xf01 = Lerp8(value[4], value[5], xs);
+		__m256 xf11 = Lerp8(value[6], value[7], xs);
+		__m256 yf0 = Lerp8(xf00, xf10, ys);
+		__m256 yf1 = Lerp8(xf01, xf11, ys);
+
+		__m256 scale = _mm256_set1_ps(PERLIN_SCALE);
+		__m256 xChange = Lerp8(Lerp8(_mm256_sub_ps(value[1], value[0]), _mm256_sub_ps(value[3], value[2]), ys),
+			Lerp8(_mm256_sub_ps(value[5], value[4]), _mm256_sub_ps(value[7], value[6]), ys), zs);
+		__m256 yChange = Lerp8(_mm256_sub_ps(xf10, xf00), _mm256_sub_ps(xf11, xf01), zs);
+		__m256 zChange = _mm256_sub_ps(yf1, yf0);
+		dx = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(InterpQuinticDerivative8(xd[0]), xChange), Trilerp8(xg, xs, ys, zs)), scale);
+		dy = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(InterpQuinticDerivative8(yd[0]), yChange), Trilerp8(yg, xs, ys, zs)), scale);
+		dz = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(InterpQuinticDerivative8(zd[0]), zChange), Trilerp8(zg, xs, ys, zs)), scale);
+
+		return _mm256_mul_ps(Lerp8(yf0, yf1, zs), scale);
+	}
+
+	AVX2_FUNCTION size_t FractalBrownianMotionGradientAVX2(int seed, const float* x, const float* y, const float* z, float* result,
+		float* gradientX, float* gradientY, float* gradientZ, size_t count, int octaves, float frequency, float amplitude)
+	{
+		__m256i seed8 = _mm256_set1_epi32(seed);
+		__m256 noiseFrequency = _mm256_set1_ps(NOISE_FREQUENCY);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 px = _mm256_loadu_ps(x + i);
+			__m256 py = _mm256_loadu_ps(y + i);
+			__m256 pz = _mm256_loadu_ps(z + i);
+
+			__m256 value = _mm256_setzero_ps();
+			__m256 gx = _mm256_setzero_ps();
+			__m256 gy = _mm256_setzero_ps();
+			__m256 gz = _mm256_setzero_ps();
+			float octaveAmplitude = amplitude;
+			float octaveFrequency = frequency;
+			for (int octave = 0; octave < octaves; octave++)
+			{
+				__m256 f = _mm256_set1_ps(octaveFrequency);
+				__m256 dx, dy, dz;
+				__m256 noise = PerlinGradient8(seed8, _mm256_mul_ps(_mm256_mul_ps(f, px), noiseFrequency),
+					_mm256_mul_ps(_mm256_mul_ps(f, py), noiseFrequency), _mm256_mul_ps(_mm256_mul_ps(f, pz), noiseFrequency), dx, dy, dz);
+				value = _mm256_add_ps(value, _mm256_mul_ps(_mm256_set1_ps(octaveAmplitude), noise));
+
+				__m256 scale = _mm256_set1_ps(octaveAmplitude * octaveFrequency * NOISE_FREQUENCY);
+				gx = _mm256_add_ps(gx, _mm256_mul_ps(scale, dx));
+				gy = _mm256_add_ps(gy, _mm256_mul_ps(scale, dy));
+				gz = _mm256_add_ps(gz, _mm256_mul_ps(scale, dz));
+
+				octaveFrequency *= 2.0f;
+				octaveAmplitude *= 0.5f;
+			}
+			_mm256_storeu_ps(result + i, value);
+			_mm256_storeu_ps(gradientX + i, gx);
+			_mm256_storeu_ps(gradientY + i, gy);
+			_mm256_storeu_ps(gradientZ + i, gz);
+		}
+
+		_mm256_zeroupper();
+		return i;
+	}
+
+	// AVX2 needs support from both the CPU and the OS
+	bool DetectAVX2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+
+		// OS saves the YMM registers
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (!osxsave || (_xgetbv(0) & 6) != 6) return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	bool HasAVX2()
+	{
+		static const bool hasAVX2 = DetectAVX2();
+		return hasAVX2;
+	}
+#endif
+
+	NoiseInstructionSet instructionSetLimit = NOISE_AVX2;
+}
+
+void SetNoiseInstructionSetLimit(NoiseInstructionSet limit)
+{
+	instructionSetLimit = limit;
+}
+
+NoiseInstructionSet GetNoiseInstructionSet()
+{
+#ifdef PERLIN_SIMD
+	auto supported = HasAVX2() ? NOISE_AVX2 : NOISE_SSE2;
+#else
+	auto supported = NOISE_SCALAR;
+#endif
+	return instructionSetLimit < supported ? instructionSetLimit : supported;
+}
+
+void FractalBrownianMotionBatch(int seed, const float* x, const float* y, const float* z, float* result,
+	size_t count, int octaves, float frequency, int firstOctave)
+{
+	// Frequency and amplitude of the first octave, stepped the same way as the full sum
+	float amplitude = 0.5f;
+	for (int octave = 0; octave < firstOctave; octave++)
+	{
+		frequency *= 2.0f;
+		amplitude *= 0.5f;
+	}
+	octaves -= firstOctave;
+
+	size_t done = 0;
+#ifdef PERLIN_SIMD
+	auto instructionSet = GetNoiseInstructionSet();
+	if (instructionSet >= NOISE_AVX2) done = FractalBrownianMotionAVX2(seed, x, y, z, result, count, octaves, frequency, amplitude);
+	if (instructionSet >= NOISE_SSE2) done += FractalBrownianMotionSSE2(seed, x + done, y + done, z + done, result + done, count - done, octaves, frequency, amplitude);
+#endif
+
+	// Positions left over from the last block
+	FractalBrownianMotionScalar(seed, x, y, z, result, done, count, octaves, frequency, amplitude);
+}
+
+void FractalBrownianMotionGradientBatch(int seed, const float* x, const float* y, const float* z, float* result,
+	float* gradientX, float* gradientY, float* gradientZ, size_t count, int octaves, float frequency, int firstOctave)
+{
+	float amplitude = 0.5f;
+	for (int octave = 0; octave < firstOctave; octave++)
+	{
+		frequency *= 2.0f;
+		amplitude *= 0.5f;
+	}
+	octaves -= firstOctave;
+
+	size_t done = 0;
+#ifdef PERLIN_SIMD
+	auto instructionSet = GetNoiseInstructionSet();
+	if (instructionSet >= NOISE_AVX2) done = FractalBrownianMotionGradientAVX2(seed, x, y, z, result, gradientX, gradientY, gradientZ, count, octaves, frequency, amplitude);
+	if (instructionSet >= NOISE_SSE2) done += FractalBrownianMotionGradientSSE2(seed, x + done, y + done, z + done, result + done,
+		gradientX + done, gradientY + done, gradientZ + done, count - done, octaves, frequency, amplitude);
+#endif
+
+	FractalBrownianMotionGradientScalar(seed, x, y, z, result, gradientX, gradientY, gradientZ, done, count, octaves, frequency, amplitude);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+// Frequency FastNoiseLite applies to its input before sampling, left at its default by the planet
+const float NOISE_FREQUENCY = 0.01f;
+
+// Evaluate FractalBrownianMotion at count positions given as separate x, y and z arrays, writing one
+// result per position. Matches FractalBrownianMotion with a FastNoiseLite object using NoiseType_Perlin,
+// the default frequency and this seed, to within float rounding. Runs 8 positions at a time with AVX2
+// or 4 with SSE2 when available, and one at a time otherwise. Safe to call from several threads.
+// Only octaves from firstOctave are summed, so detail can be added to a result with fewer octaves
+void FractalBrownianMotionBatch(int seed, const float* x, const float* y, const float* z, float* result,
+	size_t count, int octaves, float frequency, int firstOctave = 0);
+
+// Instruction sets the batch functions can run with
+enum NoiseInstructionSet
+{
+	NOISE_SCALAR = 0,
+	NOISE_SSE2 = 1,
+	NOISE_AVX2 = 2
+};
+
+// Limit the batch functions to an instruction set, so the paths can be compared. The best one the CPU
+// supports is used by default. Not safe to change while other threads are sampling noise
+void SetNoiseInstructionSetLimit(NoiseInstructionSet limit);
+
+// Instruction set the batch functions run with, the limit or the best the CPU supports if lower
+NoiseInstructionSet GetNoiseInstructionSet();
+
+// Evaluate FractalBrownianMotionBatch along with its gradient with respect to the position, for
+// surface normals without a pass over the mesh. Values match FractalBrownianMotionBatch
+void FractalBrownianMotionGradientBatch(int seed, const float* x, const float* y, const float* z, float* result,
+	float* gradientX, float* gradientY, float* gradientZ, size_t count, int octaves, float frequency, int firstOctave = 0);
@@ -4,53 +4,53 @@ Planet::Planet(Graphics* graphics)
 {
 	mGraphics = graphics;
 
-	// Create new noise object with random seed
-	mNoise = new FastNoiseLite();
-	mNoise->SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-	mNoise->SetSeed(std::rand());
+	// Random seed until the planet is created
+	mSeed = std::rand();
 }
 
 Planet::~Planet()
 {
+	WaitForChunks();
 	mGraphics = nullptr;
 }
 
 void Planet::CreatePlanet(float frequency, int octaves, int lod, int scale, int seed)
 {
+	// Workers read the noise settings, so let them finish first
+	WaitForChunks();
+
 	// Set data from params
-	mNoise->SetSeed(seed);
+	mSeed = seed;
 	mMaxLOD = lod;
 	mFrequency = frequency;
 	mOctaves = octaves;
 	mScale = scale;
-	mRadius = 0.5 * scale;
-	mMaxDistance = mRadius * (mMaxLOD + 1);
+	mRadius = 1.0f - MAX_ELEVATION;
+	mSurface.mFrequency = frequency;
+	mSurface.mOctaves = octaves;
+	mSurface.mMaxLOD = lod;
+	mSurface.mSeed = seed;
+
+	// Open the saved chunks for these parameters
+	mDiskCache.Open(mChunkCacheDirectory, { seed, frequency, octaves, int(mChunkTemplate.mBarycentrics.size()) });
 
 	// Clear old mesh
 	if (mMesh) delete mMesh;
 
 	// Reserve memory
-	mVertices.reserve(sizeof(Vertex) * MAX_PLANET_VERTS);
-	mTriangles.reserve(sizeof(Triangle) * MAX_PLANET_VERTS);
-	mIndices.reserve(sizeof(int) * MAX_PLANET_VERTS * 3);
+	mVertices.reserve(INITIAL_PLANET_VERTICES);
+	mTriangles.reserve(INITIAL_PLANET_VERTICES);
+	mIndices.reserve(INITIAL_PLANET_VERTICES * 3);
+	mVertexMap.Reserve(INITIAL_PLANET_VERTICES);
 
 	// Reset geometry to icosahedron
 	ResetGeometry();
 
 	BuildIndices();
 
-	// Calculate normals
-	auto normals = CalculateNormals(mVertices,mIndices);
-	for (int i = 0; i < mVertices.size(); i++)
-	{
-		mVertices[i].Normal = normals[i];
-	}
-
-	// Make a new mesh and calculate dynamic buffer data
+	// Make a new mesh and calculate dynamic buffer data, the buffers are written from the planet's own arrays
 	mMesh = new Mesh();
-	mMesh->mVertices = mVertices;
-	mMesh->mIndices = mIndices;
-	mMesh->CalculateDynamicBufferData();
+	mMesh->CalculateDynamicBufferData(UINT(mVertices.size()), UINT(mIndices.size()));
 }
 
 void Planet::ResetGeometry()
@@ -59,9 +59,31 @@ void Planet::ResetGeometry()
 	mVertices.clear();
 	mIndices.clear();
 	mTriangles.clear();
-	mVertexMap.clear();
-	mTriangleTree.reset();
+	mVertexMap.Clear();
 	mTriangleChunks.clear();
+	mDirtyVertexRanges.clear();
+	mDirtyIndexRanges.clear();
+
+	// Every index range needs rebuilding
+	for (NodeHandle node = 0; node < NUM_BASE_NODES; node++)
+	{
+		mBaseTriangles[node].clear();
+		mBaseDirty[node] = true;
+	}
+	mLayoutDirty = true;
+	mTreeChanged = true;
+
+	// Finish building chunks before the tree is cleared
+	WaitForChunks();
+
+	// GPU is idle when the planet is recreated
+	mRetiredChunks.Flush();
+
+	// Delete chunks owned by the old tree
+	for (auto& chunk : mNodes.mTriangleChunk)
+	{
+		if (chunk) delete chunk;
+	}
 
 	// Base Icosahedron
 	const float X = 0.525731112119133606f;
@@ -95,29 +117,51 @@ void Planet::ResetGeometry()
 		5,2,9,	11,2,7
 	};
 
+	// Base vertices are never released
+	mVertexRefs.assign(mVertices.size(), 1);
+	mFreeVertices.clear();
+
+	// Apply the octaves the base triangles show to the vertices
+	mVertexDirections.clear();
+	for (auto& vertex : mVertices)
+	{
+		mVertexDirections.push_back(vertex.Pos);
+		vertex.Normal = vertex.Pos;
+	}
+	mVertexElevations.assign(mVertices.size(), 0);
+	mVertexGradients.assign(mVertices.size(), { 0,0,0 });
+	mVertexOctaves.assign(mVertices.size(), 0);
+	for (uint32_t vertex = 0; vertex < mVertices.size(); vertex++)
+	{
+		AddVertexOctaves(vertex, mSurface.GetOctavesForLevel(0));
+	}
+	mChangedVertices.clear();
+
 	// Build triangles
 	for (int i = 0; i < mIndices.size(); i += 3)
 	{
 		mTriangles.push_back(Triangle{ mIndices[i],mIndices[i + 1],mIndices[i + 2] });
 	}
 
-	// Make quadtree and add triangles to it
-	mTriangleTree = make_unique<Node>();
-	for (auto& triangle : mTriangles)
+	// Make quadtree and add triangles to the base nodes
+	mNodes.Reset(NUM_BASE_NODES, INITIAL_PLANET_VERTICES);
+	mNodeStack.reserve(INITIAL_PLANET_VERTICES);
+	for (NodeHandle node = 0; node < NUM_BASE_NODES; node++)
 	{
-		mTriangleTree->AddSub(triangle);
+		mNodes.mTriangle[node] = mTriangles[node];
 	}
 
-	// Set subdivision distances to max on base nodes
-	for (auto& sub : mTriangleTree->mSubnodes)
+	// Calculate base node errors from the displaced surface
+	for (NodeHandle node = 0; node < NUM_BASE_NODES; node++)
 	{
-		sub->mDistance = mMaxDistance;
+		CalculateNodeBounds(node);
 	}
 
-	// Apply noise to the vertices
-	for (auto& vertex : mVertices)
+	// Check every base node on the next update
+	mNodeChecks.Clear();
+	for (NodeHandle node = 0; node < NUM_BASE_NODES; node++)
 	{
-		ApplyNoise(mFrequency, mOctaves, mNoise, vertex);
+		mNodeChecks.Push(node, mCameraTravel);
 	}
 
 	// Clear the triangles list
@@ -125,153 +169,431 @@ void Planet::ResetGeometry()
 
 }
 
-void Planet::GetTriangles(Node* node)
+void Planet::GetTriangles(NodeHandle baseNode)
 {
-	// If the node has subnodes
-	if (node->mNumSubs > 0)
+	auto& triangles = mBaseTriangles[baseNode];
+	triangles.clear();
+
+	// Walk the tree from the base node
+	mNodeStack.clear();
+	mNodeStack.push_back(baseNode);
+
+	while (!mNodeStack.empty())
 	{
-		// Call this function on each subnode
-		for (auto& subNode : node->mSubnodes)
+		NodeHandle node = mNodeStack.back();
+		mNodeStack.pop_back();
+
+		// If the node has subnodes, visit each of them
+		if (!mNodes.IsLeaf(node))
+		{
+			NodeHandle first = mNodes.mFirstChild[node];
+			for (NodeHandle child = first; child < first + NODE_CHILDREN; child++)
+			{
+				mNodeStack.push_back(child);
+			}
+		}
+		else
 		{
-			GetTriangles(subNode);
+			// Push triangle indices, unless an uploaded chunk draws the node instead.
+			// The triangle is also used while the chunk is building
+			auto chunk = mNodes.mTriangleChunk[node];
+			if (mNodes.mLevel[node] < mMaxLOD || !chunk || !chunk->mMesh)
+				triangles.push_back(mNodes.mTriangle[node]);
 		}
 	}
-	else 
+}
+
+void Planet::CullNodes()
+{
+	// Walk the tree from the base nodes
+	mNodeStack.clear();
+	for (NodeHandle node = 0; node < NUM_BASE_NODES; node++)
 	{
-		// Push triangle indices
-		if (node->mLevel < mMaxLOD) mTriangles.push_back(node->mTriangle);
-		else
+		mNodeStack.push_back(node);
+	}
+
+	while (!mNodeStack.empty())
+	{
+		NodeHandle node = mNodeStack.back();
+		mNodeStack.pop_back();
+		mCullStats.NodesVisited++;
+
+		// Cull nodes outside the frustum, culled subtrees are not refined or drawn but can still merge
+		auto visible = CheckNodeVisible(node);
+		mNodes.mVisible[node] = visible;
+
+		// If the node has subnodes, check each of them
+		if (!mNodes.IsLeaf(node))
 		{
-			// If the node has a triangle chunk, push it onto the chunks list
-			if (node->mTriangleChunk) 
-				mTriangleChunks.push_back(node->mTriangleChunk);
-			else // Push back the triangle indices instead
-				mTriangles.push_back(node->mTriangle);			
+			NodeHandle first = mNodes.mFirstChild[node];
+			for (NodeHandle child = first; child < first + NODE_CHILDREN; child++)
+			{
+				mNodeStack.push_back(child);
+			}
+			continue;
 		}
+
+		// Draw uploaded chunks in view
+		auto chunk = mNodes.mTriangleChunk[node];
+		if (visible && chunk && chunk->mMesh) mVisibleChunks.push_back(chunk);
 	}
 }
 
-bool Planet::CheckNodes(Camera* camera, Node* parentNode)
+bool Planet::RefineNodes(Camera* camera)
 {
-	bool ret = false;
-	bool combine = false;
+	// No node's distance can have changed by more than the camera has travelled
+	mCameraTravel += Distance(camera->mPos, mLastCameraPos);
+	mLastCameraPos = camera->mPos;
+
+	// Changing the split thresholds can change any decision
+	float pixelsPerUnit = ProjectError(1.0f, 1.0f, camera);
+	if (pixelsPerUnit != mLastPixelsPerUnit || mMaxPixelError != mLastMaxPixelError)
+	{
+		mLastPixelsPerUnit = pixelsPerUnit;
+		mLastMaxPixelError = mMaxPixelError;
+		QueueAllNodes();
+	}
+
+	// Check the nodes the camera has moved far enough to change
+	mLodRequests.clear();
+	mDeferredNodes.clear();
+	mNodeChecks.PopDue(mCameraTravel, mDueNodes);
+	for (auto node : mDueNodes)
+	{
+		// Skip nodes that have been released
+		if (!mNodes.IsInUse(node)) continue;
+		CheckNode(node, camera);
+	}
+
+	bool ret = ProcessLodRequests();
+
+	// Check nodes waiting on visibility or the budget again next update
+	for (auto node : mDeferredNodes)
+	{
+		mNodeChecks.Push(node, mCameraTravel);
+	}
+	return ret;
+}
+
+void Planet::CheckNode(NodeHandle node, Camera* camera)
+{
+	// Check distance from the camera to the nearest point of the node, and the error in world units
+	auto distance = CheckNodeDistance(node, camera->mPos);
+	auto nodeError = mNodes.mError[node] * mScale;
+
+	if (mNodes.IsLeaf(node))
+	{
+		bool canSplit = mNodes.mLevel[node] < mMaxLOD || !mNodes.mTriangleChunk[node];
+
+		// Subdivide the nodes to the max LOD, nearest first
+		if (!mCLOD)
+		{
+			if (canSplit) AddLodRequest(node, 1.0f / (distance + 0.0001f), true);
+			return;
+		}
 
-	// For each subnode in this node
-	for (auto node : parentNode->mSubnodes)
+		// If the node's error on screen is too large, queue a split by how far past the limit it is
+		auto error = ProjectError(nodeError, distance, camera);
+		if (error > mMaxPixelError && canSplit)
+		{
+			// Culled nodes are not split, check again once they may be in view
+			if (mNodes.mVisible[node]) AddLodRequest(node, error / mMaxPixelError, true);
+			else mDeferredNodes.push_back(node);
+			return;
+		}
+
+		// Check again once the camera could have crossed the distance the node splits at
+		auto splitDistance = ProjectError(nodeError, 1.0f, camera) / mMaxPixelError;
+		mNodeChecks.Push(node, mCameraTravel + std::abs(distance - splitDistance));
+		return;
+	}
+
+	// Only nodes whose children are all leaves can merge
+	if (!mCLOD) return;
+	NodeHandle first = mNodes.mFirstChild[node];
+	for (NodeHandle child = first; child < first + NODE_CHILDREN; child++)
+	{
+		if (!mNodes.IsLeaf(child)) return;
+	}
+
+	// Merge the children if this node is accurate enough to draw instead
+	auto mergeError = mMaxPixelError * MERGE_HYSTERESIS;
+	auto error = ProjectError(nodeError, distance, camera);
+	if (error < mergeError)
 	{
-		// If the node has no subnodes
-		if (node->mNumSubs == 0)
+		AddLodRequest(node, mergeError / (error + 0.0001f), false);
+		return;
+	}
+
+	// Check again once the camera could have crossed the distance the node merges at
+	auto mergeDistance = ProjectError(nodeError, 1.0f, camera) / mergeError;
+	mNodeChecks.Push(node, mCameraTravel + std::abs(distance - mergeDistance));
+}
+
+void Planet::QueueAllNodes()
+{
+	mNodeChecks.Clear();
+
+	mNodeStack.clear();
+	for (NodeHandle node = 0; node < NUM_BASE_NODES; node++)
+	{
+		mNodeStack.push_back(node);
+	}
+
+	while (!mNodeStack.empty())
+	{
+		NodeHandle node = mNodeStack.back();
+		mNodeStack.pop_back();
+		mNodeChecks.Push(node, mCameraTravel);
+
+		if (!mNodes.IsLeaf(node))
 		{
-			// If CLOD is enabled
-			if (mCLOD)
+			NodeHandle first = mNodes.mFirstChild[node];
+			for (NodeHandle child = first; child < first + NODE_CHILDREN; child++)
 			{
-				// Check distance from the camera to the centre of the triangle
-				auto distance = CheckNodeDistance(node, camera->mPos);
+				mNodeStack.push_back(child);
+			}
+		}
+	}
+}
 
-				// If distance is less than the nodes subdivide distance
-				if (distance < node->mDistance)
-				{
-					// Subdivide the node
-					ret = Subdivide(node, node->mLevel);
-				}
-				else if (distance > node->mDistance + mScale)
+void Planet::AddLodRequest(NodeHandle node, float priority, bool split)
+{
+	mLodRequests.push_back({ node, priority, split });
+	std::push_heap(mLodRequests.begin(), mLodRequests.end());
+}
+
+bool Planet::IsLodBudgetSpent()
+{
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - mUpdateStart;
+	return elapsed.count() > mLodBudget;
+}
+
+bool Planet::ProcessLodRequests()
+{
+	bool ret = false;
+
+	for (int processed = 0; !mLodRequests.empty(); processed++)
+	{
+		// Always make progress, then stop once the budget is spent
+		if (processed > 0 && IsLodBudgetSpent()) break;
+
+		std::pop_heap(mLodRequests.begin(), mLodRequests.end());
+		auto request = mLodRequests.back();
+		mLodRequests.pop_back();
+
+		// An earlier merge may have released the node
+		auto node = request.Node;
+		if (!mNodes.IsInUse(node)) continue;
+
+		if (request.Split)
+		{
+			if (!mNodes.IsLeaf(node)) continue;
+
+			// Over the memory budget, try again once merges have freed some
+			if (GetGeometryBytes() >= mMemoryBudget)
+			{
+				mDeferredNodes.push_back(node);
+				continue;
+			}
+			if (Subdivide(node, mNodes.mLevel[node]))
+			{
+				// Check the new leaves, and this node as a merge candidate
+				NodeHandle first = mNodes.mFirstChild[node];
+				for (NodeHandle child = first; child < first + NODE_CHILDREN; child++)
 				{
-					// Combine the node
-					if (node->mLevel > 0) { node->mCombine = true; ret = true; }
+					mNodeChecks.Push(child, mCameraTravel);
 				}
+				mNodeChecks.Push(node, mCameraTravel);
+				ret = true;
 			}
 			else
 			{
-				// Subdivide the nodes to the max LOD
-				ret = Subdivide(node, node->mLevel);
-			}		
+				// Spawned a chunk, check the node again once it is drawn
+				mDeferredNodes.push_back(node);
+			}
 		}
 		else
 		{
-			// Check the next node
-			ret = ret || CheckNodes(camera, node);
+			if (mNodes.IsLeaf(node)) continue;
+			MergeNode(node);
+
+			// Check the node as a leaf again, and its parent which may now merge too
+			mNodeChecks.Push(node, mCameraTravel);
+			if (mNodes.mParent[node] != INVALID_NODE) mNodeChecks.Push(mNodes.mParent[node], mCameraTravel);
+			ret = true;
 		}
 	}
 
+	// Requests over the budget wait for the next update
+	for (auto& request : mLodRequests)
+	{
+		mDeferredNodes.push_back(request.Node);
+	}
+	mLodRequests.clear();
+
 	return ret;
 }
 
-bool Planet::CombineNodes(Node* node)
+void Planet::MergeNode(NodeHandle node)
 {
-	// If node should be combined
-	if (node->mCombine)
+	// Release the children
+	mRemovedChunks.clear();
+	mSplitTriangles.clear();
+	mNodes.RemoveChildren(node, mRemovedChunks, mSplitTriangles);
+	mBaseDirty[mNodes.GetBaseNode(node)] = true;
+
+	// Give back the midpoints the released subdivisions were using
+	for (auto& triangle : mSplitTriangles)
 	{
-		// Delete this node and its neighbours 
-		for (auto& subNode : node->mParent->mSubnodes)
+		for (int i = 0; i < 3; i++)
 		{
-			if (subNode->mTriangleChunk)
-			{
-				subNode->mTriangleChunk->mCombine = true;
-			}
+			ReleaseVertex(triangle.Point[i], triangle.Point[(i + 1) % 3]);
 		}
-
-		// Clear the subnodes list
-		node->mParent->mSubnodes.clear();
-		node->mParent->mNumSubs = 0;
-		return true;
 	}
-	else
+
+	// Flag the chunks for deletion. Uploaded chunks may be used by commands recorded this
+	// frame, which are covered by the next fence signalled, so free them once the GPU passes it.
+	// Chunks still building are deleted when they finish
+	for (auto& chunk : mRemovedChunks)
 	{
-		// Check each subnode
-		for (auto& subNode : node->mSubnodes)
+		chunk->mCombine = true;
+		if (chunk->mMesh)
 		{
-			CombineNodes(subNode);
+			// Keep the geometry in case the node splits again, the mesh has its own copy
+			mChunkCache.Store(chunk->mCacheKey, std::move(chunk->mVertices));
+			mRetiredChunks.Retire(chunk, mGraphics->mCurrentFence + 1);
 		}
 	}
-	return false;
 }
 
 bool Planet::Update(Camera* camera, ID3D12GraphicsCommandList* commandList)
 {
-	// Sort nodes based on distance to camera
-	SortBaseNodes(camera->mPos);
 	mCurrentCommandList = commandList;
+	mUpdateStart = std::chrono::high_resolution_clock::now();
+
+	mDirtyVertexRanges.clear();
+	mDirtyIndexRanges.clear();
+
+	// Delete merged chunks the GPU has finished with
+	mRetiredChunks.Collect(mGraphics->mFence->GetCompletedValue());
+
+	// Upload chunks finished by the workers
+	bool updated = UploadChunks();
+
+	// Update visibility and gather the chunks in view, unless neither the view nor the tree
+	// have changed, in which case last update's results still hold
+	XMFLOAT4X4 viewProj;
+	XMStoreFloat4x4(&viewProj, XMMatrixMultiply(XMLoadFloat4x4(&camera->mViewMatrix), XMLoadFloat4x4(&camera->mProjectionMatrix)));
+	if (updated || mTreeChanged || memcmp(&viewProj, &mLastViewProj, sizeof(XMFLOAT4X4)) != 0)
+	{
+		mFrustum.Extract(viewProj);
+		mCameraPos = camera->mPos;
+		mCullStats = CullStats();
+		mVisibleChunks.clear();
+		CullNodes();
+
+		mLastViewProj = viewProj;
+		mTreeChanged = false;
+	}
 
-	// If a node has been updated
-	if (CheckNodes(camera, mTriangleTree.get()))
+	// Split and merge the nodes the camera has moved far enough to change
+	if (RefineNodes(camera))
 	{
-		// Check if any should be combined
-		bool combine = false;
-		for (auto& subNode : mTriangleTree->mSubnodes) { CombineNodes(subNode); }
+		// Merged chunks have been retired, stop tracking them
+		mTriangleChunks.erase(std::remove_if(mTriangleChunks.begin(), mTriangleChunks.end(),
+			[](TriangleChunk* chunk) { return chunk->mCombine; }), mTriangleChunks.end());
 
-		// If a chunk has been combined
-		for (auto& chunk : mTriangleChunks)
+		// Stop drawing the combined chunks, their parent triangles replace them
+		mVisibleChunks.erase(std::remove_if(mVisibleChunks.begin(), mVisibleChunks.end(),
+			[](TriangleChunk* chunk) { return chunk->mCombine; }), mVisibleChunks.end());
+
+		// New nodes need culling before they can be refined further
+		mTreeChanged = true;
+		updated = true;
+	}
+	mCullStats.ChunksDrawn = mVisibleChunks.size();
+
+	if (updated)
+	{
+		// Compact the vertices once enough have been released
+		if (mCompactVertices && mFreeVertices.size() > MIN_COMPACT_VERTICES &&
+			mFreeVertices.size() > mVertices.size() * COMPACT_FRACTION)
 		{
-			if (chunk->mCombine)
-				combine = true;
+			CompactVertices();
 		}
 
-		// Empty the command queue
-		if (combine)
+		// Rebuild the index ranges of the base nodes that changed
+		BuildIndices();
+
+		// Patch the mesh rather than copying all of the geometry
+		UpdateMesh();
+		return true;
+	}
+
+	return false;
+}
+
+bool Planet::UploadChunks()
+{
+	bool ret = false;
+
+	// Check each chunk still being built. Finished chunks past the budget wait for the next update,
+	// so a burst of them is spread over several frames
+	int uploaded = 0;
+	for (int i = 0; i < mPendingChunks.size();)
+	{
+		if (uploaded > 0 && IsLodBudgetSpent()) break;
+
+		auto chunk = mPendingChunks[i].first;
+		auto baseNode = mPendingChunks[i].second;
+		if (!chunk->mBuilt)
 		{
-			mGraphics->EmptyCommandQueue();			
+			i++;
+			continue;
 		}
 
-		// Delete the chunk that should be combined
-		for (auto& chunk : mTriangleChunks)
+		// Remove from the pending list
+		mPendingChunks[i] = mPendingChunks.back();
+		mPendingChunks.pop_back();
+
+		// Save new chunks for later sessions
+		mDiskCache.Append(chunk->mCacheKey.Path, chunk->mVertices);
+
+		// Chunk was merged away while building, the GPU never saw it
+		if (chunk->mCombine)
 		{
-			if (chunk->mCombine) delete chunk;
+			mChunkCache.Store(chunk->mCacheKey, std::move(chunk->mVertices));
+			delete chunk;
+			continue;
 		}
 
-		// Build the indices for the planet to render
-		BuildIndices();
+		// Create GPU buffers on the main thread
+		chunk->Upload(mCurrentCommandList);
+		uploaded++;
+		mTriangleChunks.push_back(chunk);
 
-		// Calculate dynamic buffer data and set mesh geometry
-		mMesh->mVertices = mVertices;
-		mMesh->mIndices = mIndices;
-		mMesh->CalculateDynamicBufferData();
-		return true;
+		// The chunk replaces its node's triangle
+		mBaseDirty[baseNode] = true;
+		ret = true;
 	}
 
-	return false;
+	return ret;
+}
+
+void Planet::WaitForChunks()
+{
+	mChunkWorkers.Wait();
+
+	// Merged chunks are only referenced by the pending list
+	for (auto& pending : mPendingChunks)
+	{
+		if (pending.first->mCombine) delete pending.first;
+	}
+	mPendingChunks.clear();
 }
 
-bool Planet::Subdivide(Node* node, int level)
+bool Planet::Subdivide(NodeHandle node, int level)
 {
 	auto divLevel = level;
 
@@ -281,126 +603,196 @@ bool Planet::Subdivide(Node* node, int level)
 	// If at max LOD, spawn a triangle chunk
 	if (divLevel == mMaxLOD)
 	{
-		if (node->mTriangleChunk == nullptr)
+		if (mNodes.mTriangleChunk[node] == nullptr)
 		{
-			node->mTriangleChunk = new TriangleChunk(
-				mVertices[node->mTriangle.Point[0]],
-				mVertices[node->mTriangle.Point[1]],
-				mVertices[node->mTriangle.Point[2]],
-				mFrequency, mOctaves, mNoise, mCurrentCommandList);
-			mTriangleChunks.push_back(node->mTriangleChunk);
-			return true;
+			auto& triangle = mNodes.mTriangle[node];
+			auto chunk = new TriangleChunk(
+				mVertices[triangle.Point[0]],
+				mVertices[triangle.Point[1]],
+				mVertices[triangle.Point[2]],
+				mFrequency, mOctaves, mSeed, &mChunkTemplate);
+			chunk->mCacheKey = { mNodes.GetPath(node), mSeed, mFrequency, mOctaves };
+			mNodes.mTriangleChunk[node] = chunk;
+
+			// Use cached geometry if the chunk was merged recently, then saved geometry, otherwise build it on a worker.
+			// The node's triangle is drawn until it is uploaded
+			mPendingChunks.push_back({ chunk, mNodes.GetBaseNode(node) });
+			if (mChunkCache.Take(chunk->mCacheKey, chunk->mVertices)) chunk->mBuilt = true;
+			else if (auto packed = mDiskCache.Find(chunk->mCacheKey.Path)) mChunkWorkers.AddJob([chunk, packed]() { chunk->Load(packed); });
+			else mChunkWorkers.AddJob([chunk]() { chunk->Build(); });
 		}
 		return false;		
 	}
 
+	// Make sure the edge map has room for the new midpoints
+	mVertexMap.Reserve(mVertexMap.Size() + 3);
+
 	// Subdivide the node's triangle
-	std::vector<Triangle> newTriangles = SubdivideTriangle(node->mTriangle);
+	auto newTriangles = SubdivideTriangle(mNodes.mTriangle[node]);
 
 	// Increment division level
 	divLevel++;
 
-	// Add triangles to quadtree
+	// Add the octaves the new level shows to the corners of its triangles
+	auto octaves = mSurface.GetOctavesForLevel(divLevel);
 	for (auto& triangle : newTriangles)
 	{
-		node->AddSub(triangle);
-		mTriangles.push_back(triangle);
-		node->mNumSubs++;
+		for (auto point : triangle.Point) AddVertexOctaves(point, octaves);
 	}
 
-	// Set subdivision distances
-	for (auto& sub : node->mSubnodes)
+	// Add triangles to quadtree and set subdivision distances
+	NodeHandle first = mNodes.AddChildren(node);
+	for (int i = 0; i < NODE_CHILDREN; i++)
 	{
-		sub->mLevel = divLevel;
-		sub->mDistance = mMaxDistance / divLevel;
+		mNodes.mTriangle[first + i] = newTriangles[i];
+		mNodes.mLevel[first + i] = divLevel;
+		CalculateNodeBounds(first + i);
 	}
+	EncloseChildBounds(node);
+	mBaseDirty[mNodes.GetBaseNode(node)] = true;
 	return true;
 }
 
 int Planet::GetVertexForEdge(int v1, int v2)
 {
-	// Create pair to use as key in map and normalise edge direction to prevent duplication
-	std::pair<int, int> vertexPair(v1, v2);
-	if (vertexPair.first > vertexPair.second) { std::swap(vertexPair.first, vertexPair.second); }
-
-	// Either create or reuse vertices
-	auto in = mVertexMap.insert({ vertexPair, mVertices.size() });
-	if (in.second)
+	// Either create or reuse vertices. Subdivision only runs on the main thread, so the vertex
+	// arrays can grow here without a lock
+	int vertex = mVertexMap.GetOrCreate(v1, v2, [&]()
 	{
-		auto& edge1 = mVertices[v2];
-		auto& edge2 = mVertices[v1];
-		auto newPoint = AddFloat3(edge1.Pos, edge2.Pos);
+		// Place the midpoint from the undisplaced directions, so it does not depend on how many
+		// octaves the ends have. Noise is added by the subdivision that needs it
+		auto newPoint = AddFloat3(mVertexDirections[v2], mVertexDirections[v1]);
 		Normalize(&newPoint.Pos);
-		
-		ApplyNoise(mFrequency, mOctaves, mNoise, newPoint);
+		auto direction = newPoint.Pos;
+		newPoint.Normal = direction;
+
+		// Reuse a released vertex if there is one
+		if (!mFreeVertices.empty())
+		{
+			auto index = mFreeVertices.back();
+			mFreeVertices.pop_back();
+			mVertices[index] = newPoint;
+			mVertexRefs[index] = 0;
+			mVertexDirections[index] = direction;
+			mVertexElevations[index] = 0;
+			mVertexGradients[index] = { 0,0,0 };
+			mVertexOctaves[index] = 0;
+			mChangedVertices.push_back(index);
+			return int(index);
+		}
 
 		// Add to vertex array
 		mVertices.push_back(newPoint);
-	}
-
-	return in.first->second;
+		mVertexRefs.push_back(0);
+		mVertexDirections.push_back(direction);
+		mVertexElevations.push_back(0);
+		mVertexGradients.push_back({ 0,0,0 });
+		mVertexOctaves.push_back(0);
+		return int(mVertices.size() - 1);
+	});
+
+	// Count the subdivision using the vertex
+	mVertexRefs[vertex]++;
+	return vertex;
 }
 
-float Planet::CheckNodeDistance(Node* node, XMFLOAT3 cameraPos)
+void Planet::ReleaseVertex(uint32_t v1, uint32_t v2)
 {
-	auto A = mVertices[node->mTriangle.Point[0]].Pos;
-	auto B = mVertices[node->mTriangle.Point[1]].Pos;
-	auto C = mVertices[node->mTriangle.Point[2]].Pos;
+	int vertex = mVertexMap.Find(v1, v2);
+	if (vertex < 0 || --mVertexRefs[vertex] > 0) return;
 
-	auto checkPoint = Center(A, B, C);
-	auto checkVector = XMFLOAT3{ checkPoint.x,checkPoint.y, checkPoint.z };
-	auto distance = Distance(cameraPos, checkVector);
-	
-	return distance;
+	// No subdivided triangle uses the midpoint any more
+	mVertexMap.Erase(v1, v2);
+	mFreeVertices.push_back(vertex);
 }
 
-void Planet::SortBaseNodes(XMFLOAT3 cameraPos)
+void Planet::CompactVertices()
 {
-	// Get list of distances
-	float distArray[20];
-	for (int i = 0; i < 20; i++)
+	// Collect the midpoint of every subdivided edge while the old indices are still valid
+	mCompactEdges.clear();
+	mNodeStack.clear();
+	for (NodeHandle node = 0; node < NUM_BASE_NODES; node++)
 	{
-		distArray[i] = CheckNodeDistance(mTriangleTree->mSubnodes[i], cameraPos);
+		mNodeStack.push_back(node);
 	}
 
-	// Get list of indices to sort
-	int subnodeIndices[20];
-	for (int i = 0; i < 20; i++)
+	while (!mNodeStack.empty())
 	{
-		subnodeIndices[i] = i;
-	}
+		NodeHandle node = mNodeStack.back();
+		mNodeStack.pop_back();
+		if (mNodes.IsLeaf(node)) continue;
 
-	// Sort nodes
-	for (int i = 0; i < 19; i++)
-	{
-		int minIndex = i;
-		for (int j = i + 1; j < 20; j++)
+		auto& triangle = mNodes.mTriangle[node];
+		for (int i = 0; i < 3; i++)
 		{
-			if (distArray[subnodeIndices[j]] < distArray[subnodeIndices[minIndex]])
-			{
-				minIndex = j;
-			}
+			auto v1 = triangle.Point[i];
+			auto v2 = triangle.Point[(i + 1) % 3];
+			mCompactEdges.push_back({ v1, v2, uint32_t(mVertexMap.Find(v1, v2)) });
+		}
+
+		NodeHandle first = mNodes.mFirstChild[node];
+		for (NodeHandle child = first; child < first + NODE_CHILDREN; child++)
+		{
+			mNodeStack.push_back(child);
 		}
+	}
 
-		int temp = subnodeIndices[minIndex];
-		subnodeIndices[minIndex] = subnodeIndices[i];
-		subnodeIndices[i] = temp;
+	// Slide live vertices down over the free ones, keeping their order
+	mCompactFree.assign(mVertices.size(), false);
+	for (auto vertex : mFreeVertices) mCompactFree[vertex] = true;
+
+	mCompactRemap.assign(mVertices.size(), 0);
+	uint32_t numLive = 0;
+	for (uint32_t i = 0; i < mVertices.size(); i++)
+	{
+		if (mCompactFree[i]) continue;
+		mCompactRemap[i] = numLive;
+		mVertices[numLive] = mVertices[i];
+		mVertexRefs[numLive] = mVertexRefs[i];
+		mVertexDirections[numLive] = mVertexDirections[i];
+		mVertexElevations[numLive] = mVertexElevations[i];
+		mVertexGradients[numLive] = mVertexGradients[i];
+		mVertexOctaves[numLive] = mVertexOctaves[i];
+		numLive++;
+	}
+	mVertices.resize(numLive);
+	mVertexRefs.resize(numLive);
+	mVertexDirections.resize(numLive);
+	mVertexElevations.resize(numLive);
+	mVertexGradients.resize(numLive);
+	mVertexOctaves.resize(numLive);
+	mFreeVertices.clear();
+	mChangedVertices.clear();
+
+	// Rebuild the edge map with the new indices
+	mVertexMap.Clear();
+	for (auto& edge : mCompactEdges)
+	{
+		mVertexMap.GetOrCreate(mCompactRemap[edge.V1], mCompactRemap[edge.V2], [&]() { return int(mCompactRemap[edge.Mid]); });
 	}
 
-	// Get list of sorted nodes
-	std::vector<Node*> sortedSubnodes;
-	for (int i = 0; i < 20; i++)
+	// Remap node triangles, released nodes are overwritten when reused so their values do not matter
+	for (auto& triangle : mNodes.mTriangle)
 	{
-		sortedSubnodes.push_back(mTriangleTree->mSubnodes[subnodeIndices[i]]);
+		for (auto& point : triangle.Point) point = mCompactRemap[point];
 	}
 
-	mTriangleTree->mSubnodes = sortedSubnodes;
+	// Every index range and the whole vertex buffer have changed
+	for (auto& dirty : mBaseDirty) dirty = true;
+	mLayoutDirty = true;
+	mDirtyVertexRanges.clear();
+	mDirtyVertexRanges.push_back({ 0, UINT(mVertices.size() * sizeof(Vertex)) });
 }
 
-std::vector<Triangle> Planet::SubdivideTriangle(Triangle triangle)
+float Planet::CheckNodeDistance(NodeHandle node, XMFLOAT3 cameraPos)
 {
-	std::vector<Triangle> newTriangles;
+	// Planet model is scaled in the world matrix
+	auto scale = float(mScale);
+	return NodeDistance(cameraPos, MulFloat3(mNodes.mBoundCentre[node], { scale, scale, scale }), mNodes.mBoundRadius[node] * scale);
+}
 
+std::array<Triangle, NODE_CHILDREN> Planet::SubdivideTriangle(Triangle triangle)
+{
 	// For each edge
 	std::uint32_t mid[3];
 	for (int i = 0; i < 3; i++)
@@ -408,84 +800,227 @@ std::vector<Triangle> Planet::SubdivideTriangle(Triangle triangle)
 		mid[i] = GetVertexForEdge(triangle.Point[i], triangle.Point[(i + 1) % 3]);
 	}
 
-	// Add triangles to new array
-	newTriangles.push_back({ triangle.Point[0], mid[0], mid[2] });
-	newTriangles.push_back({ triangle.Point[1], mid[1], mid[0] });
-	newTriangles.push_back({ triangle.Point[2], mid[2], mid[1] });
-	newTriangles.push_back({ mid[0], mid[1], mid[2] });
-
-	return newTriangles;
+	// Corner triangles then the middle one
+	return
+	{ {
+		{ triangle.Point[0], mid[0], mid[2] },
+		{ triangle.Point[1], mid[1], mid[0] },
+		{ triangle.Point[2], mid[2], mid[1] },
+		{ mid[0], mid[1], mid[2] },
+	} };
 }
 
 void Planet::BuildIndices()
 {
-	mTriangles.clear();
-	std::vector<TriangleChunk*> triangleChunks;
-	mTriangleChunks = triangleChunks;
-
-	for (auto& node : mTriangleTree->mSubnodes)
+	// Gather the triangles of changed base nodes, laying out again if one outgrows its range
+	bool relayout = mLayoutDirty;
+	for (NodeHandle node = 0; node < NUM_BASE_NODES; node++)
 	{
+		if (!mBaseDirty[node]) continue;
 		GetTriangles(node);
+		if (mBaseTriangles[node].size() > mBaseRanges[node].Capacity) relayout = true;
 	}
 
-	// Get indices from trinagles
-	mIndices.clear();
-	for (int i = 0; i < mTriangles.size(); i++)
+	if (relayout)
+	{
+		LayoutIndexRanges();
+	}
+	else
+	{
+		// Only patch the changed ranges
+		for (NodeHandle node = 0; node < NUM_BASE_NODES; node++)
+		{
+			if (mBaseDirty[node]) WriteIndexRange(node);
+		}
+	}
+
+	for (auto& dirty : mBaseDirty) dirty = false;
+	mLayoutDirty = false;
+}
+
+void Planet::LayoutIndexRanges()
+{
+	// Give each range room to grow if it fits in the memory budget, otherwise pack them
+	size_t total = 0;
+	for (auto& triangles : mBaseTriangles)
+	{
+		total += triangles.size() + triangles.size() / 2 + MIN_RANGE_SLACK;
+	}
+	bool slack = mVertices.size() * sizeof(Vertex) + total * 3 * sizeof(uint32_t) <= mMemoryBudget;
+
+	uint32_t start = 0;
+	for (NodeHandle node = 0; node < NUM_BASE_NODES; node++)
+	{
+		auto count = uint32_t(mBaseTriangles[node].size());
+		mBaseRanges[node].Start = start;
+		mBaseRanges[node].Capacity = slack ? count + count / 2 + MIN_RANGE_SLACK : count;
+		start += mBaseRanges[node].Capacity;
+	}
+	mIndices.resize(start * 3);
+
+	// Write every range, replacing the dirty ranges with one covering the whole buffer
+	for (NodeHandle node = 0; node < NUM_BASE_NODES; node++)
+	{
+		WriteIndexRange(node);
+	}
+	mDirtyIndexRanges.clear();
+	mDirtyIndexRanges.push_back({ 0, UINT(mIndices.size() * sizeof(uint32_t)) });
+}
+
+void Planet::WriteIndexRange(NodeHandle baseNode)
+{
+	auto& range = mBaseRanges[baseNode];
+	auto& triangles = mBaseTriangles[baseNode];
+
+	// Write the triangles then pad the rest of the range with degenerate triangles
+	auto index = mIndices.begin() + range.Start * 3;
+	for (auto& triangle : triangles)
 	{
-		mIndices.push_back(mTriangles[i].Point[0]);
-		mIndices.push_back(mTriangles[i].Point[1]);
-		mIndices.push_back(mTriangles[i].Point[2]);
+		index = std::copy(triangle.Point, triangle.Point + 3, index);
 	}
+	std::fill(index, mIndices.begin() + (range.Start + range.Capacity) * 3, 0);
+
+	mDirtyIndexRanges.push_back({ UINT(range.Start * 3 * sizeof(uint32_t)), UINT(range.Capacity * 3 * sizeof(uint32_t)) });
 }
 
-void Planet::ApplyNoise(float frequency, int octaves, FastNoiseLite* noise, Vertex& vertex)
+void Planet::UpdateMesh()
 {
-	// Sample noise at position
-	auto position = MulFloat3(vertex.Pos, { 200,200,200 });
-	auto elevationValue = FractalBrownianMotion(noise, position, octaves, frequency);
+	// Gather reused vertices into ranges, merging neighbours. The frame resources copy the ranges
+	// straight from mVertices and mIndices, so nothing is copied here
+	auto numMeshVertices = mMesh->mVertexBufferByteSize / sizeof(Vertex);
+	std::sort(mChangedVertices.begin(), mChangedVertices.end());
+	mChangedVertices.erase(std::unique(mChangedVertices.begin(), mChangedVertices.end()), mChangedVertices.end());
+	for (auto vertex : mChangedVertices)
+	{
+		// Vertices past the end of the mesh are appended below
+		if (vertex >= numMeshVertices) continue;
+
+		UINT offset = vertex * sizeof(Vertex);
+		if (!mDirtyVertexRanges.empty() && mDirtyVertexRanges.back().Offset + mDirtyVertexRanges.back().Size == offset)
+			mDirtyVertexRanges.back().Size += sizeof(Vertex);
+		else
+			mDirtyVertexRanges.push_back({ offset, UINT(sizeof(Vertex)) });
+	}
+	mChangedVertices.clear();
+
+	// Append vertices created since the last update
+	if (mVertices.size() > numMeshVertices)
+	{
+		mDirtyVertexRanges.push_back({ UINT(numMeshVertices * sizeof(Vertex)), UINT((mVertices.size() - numMeshVertices) * sizeof(Vertex)) });
+	}
 
-	// Modify elevation slightly
-	elevationValue *= 0.3;
+	mMesh->CalculateDynamicBufferData(UINT(mVertices.size()), UINT(mIndices.size()));
+}
 
-	// Get distance from vertex to planet centre
-	auto Radius = Distance(vertex.Pos, XMFLOAT3{ 0,0,0 });
+size_t Planet::GetGeometryBytes()
+{
+	// Planet arrays, by what they have allocated, and the copies uploaded from them
+	auto planetBytes = mVertices.capacity() * sizeof(Vertex) + mIndices.capacity() * sizeof(uint32_t) +
+		mTriangles.capacity() * sizeof(Triangle) + mFrameResourceBytes;
+	planetBytes += (mVertexDirections.capacity() + mVertexGradients.capacity()) * sizeof(XMFLOAT3) +
+		mVertexElevations.capacity() * sizeof(float) + mVertexOctaves.capacity();
+
+	// Drawn chunks keep their vertices, the mesh's CPU copy and the GPU copy. Building chunks only have
+	// their vertices, and merged chunks keep their mesh until the GPU is done with it while their
+	// vertices go to the cache
+	auto chunkBytes = mChunkTemplate.mBarycentrics.size() * sizeof(PlanetVertex);
+	auto chunksBytes = mTriangleChunks.size() * chunkBytes * 3 + mPendingChunks.size() * chunkBytes +
+		mRetiredChunks.Size() * chunkBytes * 2 + mChunkCache.SizeInBytes();
+	return planetBytes + chunksBytes;
+}
+
+void Planet::AddVertexOctaves(uint32_t vertex, int octaves)
+{
+	if (mVertexOctaves[vertex] >= octaves) return;
+
+	// Sum the missing octaves onto the vertex's elevation and its gradient
+	auto position = MulFloat3(mVertexDirections[vertex], { 200,200,200 });
+	float detail;
+	XMFLOAT3 gradient;
+	FractalBrownianMotionGradientBatch(mSeed, &position.x, &position.y, &position.z, &detail,
+		&gradient.x, &gradient.y, &gradient.z, 1, octaves, mFrequency, mVertexOctaves[vertex]);
+	mVertexElevations[vertex] += detail;
+	mVertexGradients[vertex] = AddFloat3(mVertexGradients[vertex], gradient).Pos;
+	mVertexOctaves[vertex] = uint8_t(octaves);
+
+	// Displace along the direction, as PlanetSurface::GetPoint does, and light with the slope of the noise
+	auto& direction = mVertexDirections[vertex];
+	auto height = mVertexElevations[vertex] * MAX_ELEVATION;
+	auto scale = 1 + height;
+	mVertices[vertex].Pos = MulFloat3(direction, { scale, scale, scale });
+	auto gradientScale = MAX_ELEVATION * 200;
+	mVertices[vertex].Normal = DisplacedSphereNormal(direction, height, MulFloat3(mVertexGradients[vertex], { gradientScale, gradientScale, gradientScale }));
+	mChangedVertices.push_back(vertex);
+}
 
-	// Apply noise
-	vertex.Pos.x *= 1 + (elevationValue / Radius);
-	vertex.Pos.y *= 1 + (elevationValue / Radius);
-	vertex.Pos.z *= 1 + (elevationValue / Radius);
+void Planet::CalculateNodeBounds(NodeHandle node)
+{
+	// Bound the surface over the node's triangle
+	auto& triangle = mNodes.mTriangle[node];
+	auto bounds = mSurface.BoundTriangle(mVertices[triangle.Point[0]].Pos, mVertices[triangle.Point[1]].Pos,
+		mVertices[triangle.Point[2]].Pos, mNodes.mLevel[node]);
+	mNodes.mError[node] = bounds.Error;
+	mNodes.mBoundCentre[node] = bounds.Centre;
+	mNodes.mBoundRadius[node] = bounds.Radius;
+	mNodes.mMaxRadius[node] = bounds.MaxRadius;
 }
 
-float Planet::CheckNodeTriSize(Node* node, Camera* camera)
+void Planet::EncloseChildBounds(NodeHandle node)
 {
-	// Get triangle positions
-	auto A = mVertices[node->mTriangle.Point[0]].Pos;
-	auto B = mVertices[node->mTriangle.Point[1]].Pos;
-	auto C = mVertices[node->mTriangle.Point[2]].Pos;
+	for (; node != INVALID_NODE; node = mNodes.mParent[node])
+	{
+		NodeBounds bounds;
+		bounds.Centre = mNodes.mBoundCentre[node];
+		bounds.Radius = mNodes.mBoundRadius[node];
+		bounds.MaxRadius = mNodes.mMaxRadius[node];
+
+		bool grown = false;
+		NodeHandle first = mNodes.mFirstChild[node];
+		for (NodeHandle child = first; child < first + NODE_CHILDREN; child++)
+		{
+			grown |= EncloseBounds(bounds, { 0, mNodes.mBoundCentre[child], mNodes.mBoundRadius[child], mNodes.mMaxRadius[child] });
+		}
 
-	// Set up DirectX math
-	auto vA = XMLoadFloat3(&A);
-	auto vB = XMLoadFloat3(&B);
-	auto vC = XMLoadFloat3(&C);
-	auto mV = XMLoadFloat4x4(&camera->mViewMatrix);
-	auto mP = XMLoadFloat4x4(&camera->mProjectionMatrix);
+		// Ancestors already hold this node's old bounds, and so everything under it until now
+		if (!grown) return;
+		mNodes.mBoundCentre[node] = bounds.Centre;
+		mNodes.mBoundRadius[node] = bounds.Radius;
+		mNodes.mMaxRadius[node] = bounds.MaxRadius;
 
-	// Multiply each point by the view matrix
-	auto viewA = XMVector3Transform(vA, mV);
-	auto viewB = XMVector3Transform(vB, mV);
-	auto viewC = XMVector3Transform(vC, mV);
+		// Its distance is measured from the centre, so check it again
+		mNodeChecks.Push(node, mCameraTravel);
+	}
+}
 
-	// Multiply each point by the projection matrix
-	auto viewProjA = XMVector3Transform(viewA, mP);
-	auto viewProjB = XMVector3Transform(viewB, mP);
-	auto viewProjC = XMVector3Transform(viewC, mP);
+NodeVisibility Planet::CheckNodeVisible(NodeHandle node)
+{
+	auto parent = mNodes.mParent[node];
+	auto parentVisibility = parent != INVALID_NODE ? mNodes.mVisible[parent] : NODE_VISIBLE;
+
+	// Planet model is scaled in the world matrix
+	auto scale = float(mScale);
+	auto centre = MulFloat3(mNodes.mBoundCentre[node], { scale, scale, scale });
+	bool belowHorizon;
+	auto visibility = CheckSphereVisible(mFrustum, mCameraPos, mRadius * scale, centre, mNodes.mBoundRadius[node] * scale,
+		mNodes.mMaxRadius[node] * scale, parentVisibility, &belowHorizon);
+
+	// Count only nodes that were tested
+	if (visibility == NODE_CULLED && parentVisibility != NODE_CULLED)
+	{
+		if (belowHorizon) mCullStats.NodesBelowHorizon++;
+		else mCullStats.NodesCulled++;
+	}
+	return visibility;
+}
 
-	// Store the new positions
-	XMStoreFloat3(&A, viewProjA);
-	XMStoreFloat3(&B, viewProjB);
-	XMStoreFloat3(&C, viewProjC);
+bool Planet::IsBelowHorizon(XMFLOAT3 cameraPos, XMFLOAT3 centre, float radius)
+{
+	return IsObjectBelowHorizon(cameraPos, mRadius * mScale, centre, radius);
+}
 
-	// Measure the distance of a side and return
-	auto distance = Distance(A, B);
-	return distance;
-}
\ No newline at end of file
+float Planet::ProjectError(float error, float distance, Camera* camera)
+{
+	// Pixels per unit at a distance of one, the projection's y scale covers half the screen height
+	float pixelsPerUnit = camera->mProjectionMatrix._22 * camera->mWindowHeight * 0.5f;
+	return ProjectNodeError(error, distance, pixelsPerUnit);
+}
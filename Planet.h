@@ -4,51 +4,31 @@
 #include "Mesh.h"
 #include "Camera.h"
 #include "TriangleChunk.h"
+#include "ChunkTemplate.h"
 #include "Common.h"
 #include "Graphics.h"
+#include "EdgeVertexMap.h"
+#include "NodePool.h"
+#include "ThreadPool.h"
+#include "RetirementQueue.h"
+#include "NodeCheckQueue.h"
+#include "Frustum.h"
+#include "ChunkCache.h"
+#include "ChunkDiskCache.h"
+#include "PerlinNoise.h"
+#include "PlanetSurface.h"
 
 #include <DirectXColors.h>
 #include <vector>
 #include <memory>
-#include <map>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <string>
 
 #include "FastNoiseLite.h"
 
-class Node
-{
-private:
-public:
-	Node* mParent;
-	std::vector<Node*> mSubnodes;
-	int mNumSubs = 0;
-	Triangle mTriangle = {0,0,0};
-	float mDistance = 0;
-	int mLevel = 0;
-	bool mCombine = false;
-	TriangleChunk* mTriangleChunk = nullptr;
-	Node() : mParent{ 0 } {};
-	Node(Node* parent) : mParent{ parent } {};
-	~Node()
-	{
-		if (mTriangleChunk) delete mTriangleChunk;
-		for (auto& subNode : mSubnodes)
-		{
-			mParent = nullptr;
-			delete subNode;
-		}
-		mSubnodes.clear();
-	}
-	Node* AddSub(Triangle triangle)
-	{
-		Node* newNode = new Node(this);
-		newNode->mTriangle = triangle;
-		mSubnodes.push_back(newNode);
-		mNumSubs++;
-		return newNode;
-	};
-};
-
-
 class Planet
 {
 public:
@@ -64,8 +44,10 @@ public:
 	// Update planet
 	bool Update(Camera* camera, ID3D12GraphicsCommandList* commandList);
 
-	// Planet mesh
+	// Planet mesh, its dynamic buffers are written from the vertices and indices below
 	Mesh* mMesh;
+	const std::vector<Vertex>& GetVertices() const { return mVertices; }
+	const std::vector<uint32_t>& GetIndices() const { return mIndices; }
 
 	// Max LOD to subdivide to
 	int mMaxLOD = 0;
@@ -76,8 +58,60 @@ public:
 	// Enable CLOD
 	bool mCLOD = false;
 
+	// Geometry of merged chunks, kept to split again without building
+	ChunkCache mChunkCache;
+
+	// Chunk geometry saved between sessions
+	ChunkDiskCache mDiskCache;
+
+	// Directory for saved chunks, read when the planet is created. Empty to disable saving
+	std::string mChunkCacheDirectory = "ChunkCache";
+
+	// Milliseconds each update may spend uploading chunks, splitting and merging, the rest wait for later updates
+	float mLodBudget = 2.0f;
+
+	// Bytes of planet and chunk geometry resident on the CPU and GPU, splits wait once it is reached until
+	// merges free some
+	size_t mMemoryBudget = size_t(256) << 20;
+
+	// Bytes of the planet mesh copies held by the frame resources, set by the app as the planet cannot see them
+	size_t mFrameResourceBytes = 0;
+
+	// Bytes of geometry resident for the planet: its CPU arrays and frame resource copies, and chunks
+	// whether drawn, building, waiting for the GPU or cached
+	size_t GetGeometryBytes();
+
+	// Remove released vertices from the vertex array once enough build up, remapping indices
+	bool mCompactVertices = true;
+
+	// Projected geometric error in pixels above which a node is split
+	float mMaxPixelError = 4.0f;
+
 	// List of chunks
 	std::vector<TriangleChunk*> mTriangleChunks;
+
+	// Chunks inside the view frustum this frame
+	std::vector<TriangleChunk*> mVisibleChunks;
+
+	// Culling results from the last update
+	struct CullStats
+	{
+		int NodesVisited = 0;
+		int NodesCulled = 0;
+		int NodesBelowHorizon = 0;
+		int ChunksDrawn = 0;
+	};
+	CullStats mCullStats;
+
+	// Byte ranges of the planet mesh buffers changed by the last update, for the upload step
+	std::vector<ByteRange> mDirtyVertexRanges;
+	std::vector<ByteRange> mDirtyIndexRanges;
+
+	// Is a world space sphere around an object hidden behind the planet from the camera
+	bool IsBelowHorizon(XMFLOAT3 cameraPos, XMFLOAT3 centre, float radius);
+
+	// Noise displaces the unit sphere by less than this, chunks and saved heights are scaled by it too
+	static constexpr float MAX_ELEVATION = PlanetSurface::MAX_ELEVATION;
 private:
 	
 	// Reference to the graphics class
@@ -88,52 +122,208 @@ private:
 	std::vector<Vertex> mVertices;
 	std::vector<uint32_t> mIndices;
 	std::vector<Triangle> mTriangles;
-	std::vector<XMFLOAT3> mNormals;
-	std::map<std::pair<int, int>, int> mVertexMap;
+	EdgeVertexMap mVertexMap;
 
 	// Geometry Quadtree
-	unique_ptr<Node> mTriangleTree;
+	static const int NUM_BASE_NODES = 20;
+	NodePool mNodes;
+
+	// Each base node draws its tree from a stable range of the index buffer, in triangles.
+	// Space past the node's triangles is filled with degenerate triangles so it can grow in place
+	struct IndexRange
+	{
+		uint32_t Start = 0;
+		uint32_t Capacity = 0;
+	};
+	IndexRange mBaseRanges[NUM_BASE_NODES];
+	std::vector<Triangle> mBaseTriangles[NUM_BASE_NODES];
+	bool mBaseDirty[NUM_BASE_NODES];
+	bool mLayoutDirty = true;
+
+	// Extra triangles given to each range when laying them out
+	const uint32_t MIN_RANGE_SLACK = 16;
+
+	// Scratch stack for iterative traversal
+	std::vector<NodeHandle> mNodeStack;
+
+	// Nodes waiting to have their split or merge checked
+	NodeCheckQueue<NodeHandle> mNodeChecks;
+	std::vector<NodeHandle> mDueNodes;
+	std::vector<NodeHandle> mDeferredNodes;
+
+	// Total distance the camera has moved, and the values the queued checks were made with
+	double mCameraTravel = 0;
+	XMFLOAT3 mLastCameraPos = { 0,0,0 };
+	float mLastPixelsPerUnit = 0;
+	float mLastMaxPixelError = 0;
+
+	// Splits and merges found by the checks, kept as a heap with the most urgent first
+	struct LodRequest
+	{
+		NodeHandle Node;
+		float Priority;
+		bool Split;
+		bool operator<(const LodRequest& other) const { return Priority < other.Priority; }
+	};
+	std::vector<LodRequest> mLodRequests;
 
-	// Radius of planet
-	float mRadius = 0.5f;
-	float mMaxDistance = 0.0f;
+	// Camera frustum and position for the current update
+	Frustum mFrustum;
+	XMFLOAT3 mCameraPos = { 0,0,0 };
+
+	// View projection of the last cull. Culling is skipped while it and the tree are unchanged
+	XMFLOAT4X4 mLastViewProj = {};
+	bool mTreeChanged = true;
+
+	// Chunks and subdivided triangles released by merged nodes
+	std::vector<TriangleChunk*> mRemovedChunks;
+	std::vector<Triangle> mSplitTriangles;
+
+	// Number of subdivided triangles using each vertex as an edge midpoint. Vertices
+	// released by every triangle go on the free list to be reused by new edges
+	std::vector<uint32_t> mVertexRefs;
+	std::vector<uint32_t> mFreeVertices;
+
+	// Reused vertices and vertices given more octaves since the last update. Only these have their
+	// position and normal copied to the mesh, so the work follows the splits rather than the mesh size
+	std::vector<uint32_t> mChangedVertices;
+
+	// Undisplaced direction of each vertex, with the noise summed over its first octaves. Vertices
+	// only get the octaves their finest triangle can show, and more are added as triangles split
+	std::vector<XMFLOAT3> mVertexDirections;
+	std::vector<float> mVertexElevations;
+	std::vector<XMFLOAT3> mVertexGradients; // Of the elevation, for normals
+	std::vector<uint8_t> mVertexOctaves;
+
+	// Vertices to reserve room for when the planet is created, the arrays grow past it as needed
+	const int INITIAL_PLANET_VERTICES = 25000;
+
+	// Compact once this many vertices are free, and they make up this fraction of the array
+	const int MIN_COMPACT_VERTICES = 1024;
+	const float COMPACT_FRACTION = 0.25f;
+
+	// Scratch edges and midpoints kept through compaction
+	struct EdgeVertex
+	{
+		uint32_t V1;
+		uint32_t V2;
+		uint32_t Mid;
+	};
+	std::vector<EdgeVertex> mCompactEdges;
+
+	// Scratch flags for free vertices and the new index of each vertex, kept through compaction
+	std::vector<uint8_t> mCompactFree;
+	std::vector<uint32_t> mCompactRemap;
+
+	// Topology shared by every chunk
+	ChunkTemplate mChunkTemplate;
+
+	// Workers building chunk geometry and the chunks they have not finished
+	ThreadPool mChunkWorkers;
+	std::vector<std::pair<TriangleChunk*, NodeHandle>> mPendingChunks; // With the base node drawing them until uploaded
+
+	// Merged chunks waiting for the GPU to finish with them
+	RetirementQueue<TriangleChunk> mRetiredChunks;
+
+	// Radius of a sphere under the lowest terrain, used to occlude nodes behind the horizon
+	float mRadius = 1.0f - MAX_ELEVATION;
+
+	// Fraction of the split error below which nodes merge, stops nodes flickering at the threshold
+	const float MERGE_HYSTERESIS = 0.5f;
 
 	// Noise variables
 	float mFrequency;
 	int mOctaves;
-	FastNoiseLite* mNoise;
+	int mSeed = 0;
+
+	// Noise displaced surface for the current settings, bounds the nodes
+	PlanetSurface mSurface;
 
-	// Build indices to render the planet
+	// Rebuild the index ranges of changed base nodes
 	void BuildIndices();
 
-	// Get triangles for indexing or chunks from maxLOD nodes
-	void GetTriangles(Node* node);
+	// Get the triangles to index from a base node's tree, leaving out nodes drawn by uploaded chunks
+	void GetTriangles(NodeHandle baseNode);
 
-	// Sort nodes by distance to the camera
-	void SortBaseNodes(XMFLOAT3 cameraPos);
+	// Place every base node's range in the index buffer and write them all
+	void LayoutIndexRanges();
 
-	// Check node distance to camera
-	float CheckNodeDistance(Node* node, XMFLOAT3 cameraPos);
+	// Write a base node's triangles into its range and record it as dirty
+	void WriteIndexRange(NodeHandle baseNode);
+
+	// Patch the mesh with the vertices and index ranges changed this update
+	void UpdateMesh();
+
+
+	// Check node distance to camera, to the nearest point of the node's bounds scaled to world space
+	float CheckNodeDistance(NodeHandle node, XMFLOAT3 cameraPos);
+
+	// Upload chunks the workers have finished until the update's budget is spent, returns true if any were added
+	bool UploadChunks();
+
+	// When the current update started, uploads and LOD requests share its budget
+	std::chrono::high_resolution_clock::time_point mUpdateStart;
+
+	// Has the update spent its budget
+	bool IsLodBudgetSpent();
+
+	// Wait for chunk jobs and delete pending chunks that are no longer in the tree
+	void WaitForChunks();
 
 	// Subdivide node
-	bool Subdivide(Node* node, int level = 0);
+	bool Subdivide(NodeHandle node, int level = 0);
 
-	// Get a vertex for triangle edge
+	// Get a vertex for triangle edge. Main thread only: the edge table is lock free, but a new
+	// midpoint is appended to the vertex arrays, which are not
 	int GetVertexForEdge(int v1, int v2);
+
+	// Release a subdivided edge's use of its midpoint vertex
+	void ReleaseVertex(uint32_t v1, uint32_t v2);
+
+	// Move live vertices over the free ones and remap every index to them
+	void CompactVertices();
 	
-	// Subdivide triangle
-	std::vector<Triangle> SubdivideTriangle(Triangle triangle);
+	// Subdivide triangle into the four children, in child order
+	std::array<Triangle, NODE_CHILDREN> SubdivideTriangle(Triangle triangle);
 
-	// Check each node for updates
-	bool CheckNodes(Camera* camera, Node* parentNode);
+	// Update node visibility and gather the chunks in view
+	void CullNodes();
 
-	// Combine nodes if flagged
-	bool CombineNodes(Node* node);
+	// Check the nodes that are due and split or merge them
+	bool RefineNodes(Camera* camera);
+
+	// Queue a split or merge for a node if needed, otherwise queue its next check
+	void CheckNode(NodeHandle node, Camera* camera);
+
+	// Queue every node in the tree to be checked
+	void QueueAllNodes();
+
+	// Queue a split or merge for a node
+	void AddLodRequest(NodeHandle node, float priority, bool split);
+
+	// Carry out the most urgent requests until the time budget is spent
+	bool ProcessLodRequests();
+
+	// Release a node's children and everything they own
+	void MergeNode(NodeHandle node);
 	
-	// Apply noise to the geometry
-	void ApplyNoise(float frequency, int octaves, FastNoiseLite* noise, Vertex& vertex);
+	// Add octaves to a vertex's elevation until it has this many, updating its position and normal.
+	// The normal comes from the noise gradient at the vertex alone, so a split or merge never needs
+	// the normals of the vertices around it recalculating
+	void AddVertexOctaves(uint32_t vertex, int octaves);
+
+	// Calculate the maximum deviation of the surface from a node's flat triangle, and a bounding sphere
+	void CalculateNodeBounds(NodeHandle node);
+
+	// Grow a node's bounds to contain its children's, and its ancestors' to contain theirs, so a culled
+	// node's subtree is culled and an inside node's subtree is inside
+	void EncloseChildBounds(NodeHandle node);
+
+	// Test a node's bounding sphere against the frustum and horizon, nodes under a culled parent are culled without a test
+	// and nodes under a parent inside the frustum only test the horizon, which holds as children's bounds are nested
+	NodeVisibility CheckNodeVisible(NodeHandle node);
 
-	// Get size of triangle on screen UNUSED
-	float CheckNodeTriSize(Node* node, Camera* camera);
+	// Project a geometric error at a distance from the camera to pixels on screen
+	float ProjectError(float error, float distance, Camera* camera);
 };
 
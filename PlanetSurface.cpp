@@ -0,0 +1,175 @@
+#include "PlanetSurface.h"
+#include "PerlinNoise.h"
+
+#include <cfloat>
+#include <cmath>
+
+int PlanetSurface::GetOctavesForLevel(int level) const
+{
+	// The last level is the surface that is drawn, so it gets every octave
+	if (level >= mMaxLOD) return mOctaves;
+
+	// Keep octaves with a wavelength of at least half the level's edge length, the noise input is scaled by 200
+	float edgeLength = BASE_EDGE_LENGTH / float(1 << level);
+	float wavelength = 1.0f / (200 * NOISE_FREQUENCY * mFrequency);
+	int octaves = 0;
+	while (octaves < mOctaves && wavelength >= edgeLength * 0.5f)
+	{
+		octaves++;
+		wavelength *= 0.5f;
+	}
+	return octaves;
+}
+
+float PlanetSurface::GetRemainingElevation(int octaves) const
+{
+	// Octave amplitudes halve from a half, and the noise stays within one
+	return MAX_ELEVATION * (std::pow(0.5f, float(octaves)) - std::pow(0.5f, float(mOctaves)));
+}
+
+XMFLOAT3 PlanetSurface::GetPoint(XMFLOAT3 position, int octaves) const
+{
+	// Project onto the sphere and sample noise there
+	auto direction = position;
+	Normalize(&direction);
+	auto samplePosition = MulFloat3(direction, { 200,200,200 });
+	float elevation;
+	FractalBrownianMotionBatch(mSeed, &samplePosition.x, &samplePosition.y, &samplePosition.z, &elevation, 1, octaves, mFrequency);
+
+	// Displace along the direction, as done for new vertices
+	auto scale = 1 + elevation * MAX_ELEVATION;
+	return MulFloat3(direction, { scale, scale, scale });
+}
+
+NodeBounds PlanetSurface::BoundTriangle(XMFLOAT3 A, XMFLOAT3 B, XMFLOAT3 C, int level) const
+{
+	NodeBounds bounds;
+
+	// Plane of the flat triangle
+	auto normal = CrossProduct(SubFloat3(B, A), SubFloat3(C, A));
+	Normalize(&normal);
+
+	// Sample the surface at the edge midpoints, where subdivision will place vertices, and the centre.
+	// Only the octaves the next level shows are sampled, the rest can add at most their amplitude
+	XMFLOAT3 samples[4] = { Midpoint(A, B), Midpoint(B, C), Midpoint(C, A), Center(A, B, C) };
+	auto octaves = GetOctavesForLevel(level + 1);
+
+	// Store the largest distance of the surface from the plane
+	float error = 0;
+	for (auto& sample : samples)
+	{
+		auto surfacePoint = GetPoint(sample, octaves);
+		auto deviation = std::abs(DotProduct(SubFloat3(surfacePoint, A), normal));
+		if (deviation > error) error = deviation;
+	}
+	bounds.Error = error + GetRemainingElevation(octaves);
+
+	// The sampled error is doubled as it can miss peaks between samples. Octaves the level does not show
+	// can add their amplitude anywhere, including to the corners once a finer neighbour needs them
+	auto padding = error * 2 + GetRemainingElevation(GetOctavesForLevel(level));
+
+	// Bound the corners, padded so the sphere holds the surface above and below the triangle
+	auto centre = Center(A, B, C);
+	float radius = Distance(centre, A);
+	radius = radius > Distance(centre, B) ? radius : Distance(centre, B);
+	radius = radius > Distance(centre, C) ? radius : Distance(centre, C);
+	bounds.Centre = centre;
+	bounds.Radius = radius + padding;
+
+	// Highest the surface can reach, the flat triangle is no further out than its corners.
+	// The noise can never displace the surface further than the maximum elevation
+	float maxRadius = Distance(A, XMFLOAT3{ 0,0,0 });
+	maxRadius = maxRadius > Distance(B, XMFLOAT3{ 0,0,0 }) ? maxRadius : Distance(B, XMFLOAT3{ 0,0,0 });
+	maxRadius = maxRadius > Distance(C, XMFLOAT3{ 0,0,0 }) ? maxRadius : Distance(C, XMFLOAT3{ 0,0,0 });
+	maxRadius += padding;
+	bounds.MaxRadius = maxRadius < 1 + MAX_ELEVATION ? maxRadius : 1 + MAX_ELEVATION;
+	return bounds;
+}
+
+bool EncloseBounds(NodeBounds& bounds, const NodeBounds& child)
+{
+	bool grown = false;
+	if (child.MaxRadius > bounds.MaxRadius)
+	{
+		bounds.MaxRadius = child.MaxRadius;
+		grown = true;
+	}
+
+	// Nothing to do if the child's sphere is already inside
+	auto offset = SubFloat3(child.Centre, bounds.Centre);
+	float distance = Distance(child.Centre, bounds.Centre);
+	if (distance + child.Radius <= bounds.Radius) return grown;
+
+	// Take the child's sphere if it holds this one
+	if (distance + bounds.Radius <= child.Radius)
+	{
+		bounds.Centre = child.Centre;
+		bounds.Radius = child.Radius;
+		return true;
+	}
+
+	// Otherwise the smallest sphere holding both, from the far side of one to the far side of the other
+	float radius = (distance + bounds.Radius + child.Radius) * 0.5f;
+	float shift = (radius - bounds.Radius) / distance;
+	bounds.Centre = AddFloat3(bounds.Centre, MulFloat3(offset, { shift, shift, shift })).Pos;
+	bounds.Radius = radius;
+	return true;
+}
+
+float NodeDistance(XMFLOAT3 cameraPos, XMFLOAT3 centre, float radius)
+{
+	// Any point of the node can be the nearest, so measure to the sphere rather than its centre
+	auto distance = Distance(cameraPos, centre) - radius;
+	return distance > 0 ? distance : 0;
+}
+
+float ProjectNodeError(float error, float distance, float pixelsPerUnit)
+{
+	if (distance <= 0.0001f) return FLT_MAX;
+	return error * pixelsPerUnit / distance;
+}
+
+bool IsBelowHorizon(XMFLOAT3 cameraPos, float occluderRadius, XMFLOAT3 centre, float radius, float maxRadius)
+{
+	// Nothing is occluded from inside the occluding sphere
+	float cameraDistance = Distance(cameraPos, XMFLOAT3{ 0,0,0 });
+	if (cameraDistance <= occluderRadius) return false;
+
+	// Distance to the horizon, plus how far past it a point at maxRadius can still be seen
+	float horizon = sqrtf(cameraDistance * cameraDistance - occluderRadius * occluderRadius);
+	float beyond = maxRadius > occluderRadius ? sqrtf(maxRadius * maxRadius - occluderRadius * occluderRadius) : 0;
+
+	// Hidden if even the nearest point of the sphere is further than any visible point could be
+	return Distance(cameraPos, centre) - radius > horizon + beyond;
+}
+
+bool IsObjectBelowHorizon(XMFLOAT3 cameraPos, float occluderRadius, XMFLOAT3 centre, float radius)
+{
+	auto maxRadius = Distance(centre, XMFLOAT3{ 0,0,0 }) + radius;
+	return IsBelowHorizon(cameraPos, occluderRadius, centre, radius, maxRadius);
+}
+
+NodeVisibility CheckSphereVisible(const Frustum& frustum, XMFLOAT3 cameraPos, float occluderRadius, XMFLOAT3 centre,
+	float radius, float maxRadius, NodeVisibility parentVisibility, bool* belowHorizon)
+{
+	if (belowHorizon) *belowHorizon = false;
+
+	// Children of a culled node are culled too
+	if (parentVisibility == NODE_CULLED) return NODE_CULLED;
+
+	// Children of a node inside the frustum are inside too
+	auto visibility = NODE_INSIDE;
+	if (parentVisibility != NODE_INSIDE)
+	{
+		if (!frustum.IntersectsSphere(centre, radius)) return NODE_CULLED;
+		if (!frustum.ContainsSphere(centre, radius)) visibility = NODE_VISIBLE;
+	}
+
+	// Cull nodes hidden behind the curve of the planet
+	if (IsBelowHorizon(cameraPos, occluderRadius, centre, radius, maxRadius))
+	{
+		if (belowHorizon) *belowHorizon = true;
+		return NODE_CULLED;
+	}
+	return visibility;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Utility.h"
+#include "Frustum.h"
+#include "NodePool.h"
+
+// Bounds of the surface over a node's triangle
+struct NodeBounds
+{
+	float Error = 0;            // Largest distance of the surface from the flat triangle
+	XMFLOAT3 Centre = { 0,0,0 };
+	float Radius = 0;
+	float MaxRadius = 0;        // Furthest the surface reaches from the planet centre
+};
+
+// Noise displaced surface of the planet. Holds only the noise settings, so node bounds and culling
+// can be checked without a window or device
+class PlanetSurface
+{
+public:
+	// Noise displaces the unit sphere by less than this, as the FBM octave amplitudes sum below one
+	static constexpr float MAX_ELEVATION = 0.3f;
+
+	// Edge length of the base icosahedron on the unit sphere
+	static constexpr float BASE_EDGE_LENGTH = 1.05146222f;
+
+	float mFrequency = 0;
+	int mOctaves = 0;
+	int mMaxLOD = 0;
+	int mSeed = 0;
+
+	// Number of octaves that show on triangles of a level, finer octaves fall between their vertices
+	int GetOctavesForLevel(int level) const;
+
+	// Largest elevation the octaves after the first few can add
+	float GetRemainingElevation(int octaves) const;
+
+	// Get noise displaced surface point in the direction of a position, using the first few octaves
+	XMFLOAT3 GetPoint(XMFLOAT3 position, int octaves) const;
+
+	// Bound the surface over a triangle of a level, whose corners have at least that level's octaves
+	NodeBounds BoundTriangle(XMFLOAT3 A, XMFLOAT3 B, XMFLOAT3 C, int level) const;
+};
+
+// Grow bounds to contain a child's bounds, so tests passed or failed by a node hold for its children.
+// Returns true if the bounds grew
+bool EncloseBounds(NodeBounds& bounds, const NodeBounds& child);
+
+// Distance from the camera to the nearest point of a node's bounding sphere, zero when the camera is inside it
+float NodeDistance(XMFLOAT3 cameraPos, XMFLOAT3 centre, float radius);
+
+// Project a geometric error at a distance to pixels, given the pixels a unit covers at a distance of one.
+// Nodes the camera is inside always split, so their error is as large as it can be
+float ProjectNodeError(float error, float distance, float pixelsPerUnit);
+
+// Is a sphere hidden behind an occluding sphere at the origin from the camera. maxRadius is the
+// furthest any part of it reaches from the origin
+bool IsBelowHorizon(XMFLOAT3 cameraPos, float occluderRadius, XMFLOAT3 centre, float radius, float maxRadius);
+
+// Is an object's bounding sphere hidden behind an occluding sphere at the origin from the camera.
+// The object can be anywhere, so the sphere reaches as far from the origin as its far side
+bool IsObjectBelowHorizon(XMFLOAT3 cameraPos, float occluderRadius, XMFLOAT3 centre, float radius);
+
+// Test a bounding sphere against the frustum and the horizon. Spheres under a culled parent are culled
+// without a test and spheres under a parent inside the frustum only test the horizon. belowHorizon is
+// set when the horizon culled it
+NodeVisibility CheckSphereVisible(const Frustum& frustum, XMFLOAT3 cameraPos, float occluderRadius, XMFLOAT3 centre,
+	float radius, float maxRadius, NodeVisibility parentVisibility, bool* belowHorizon = nullptr);
@@ -0,0 +1,54 @@
+#include "PlanetVertex.h"
+#include <cmath>
+
+PlanetVertex EncodePlanetVertex(const Vertex& vertex)
+{
+	PlanetVertex packed;
+	packed.Pos = vertex.Pos;
+	EncodeOctahedralNormal(vertex.Normal, packed.Normal);
+	return packed;
+}
+
+Vertex DecodePlanetVertex(const PlanetVertex& vertex)
+{
+	Vertex unpacked;
+	unpacked.Pos = vertex.Pos;
+	unpacked.Normal = DecodeOctahedralNormal(vertex.Normal);
+	return unpacked;
+}
+
+void EncodeOctahedralNormal(XMFLOAT3 normal, std::int16_t packed[2])
+{
+	// Project onto the octahedron
+	auto sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	float x = sum > 0 ? normal.x / sum : 0;
+	float y = sum > 0 ? normal.y / sum : 0;
+	if (normal.z < 0)
+	{
+		float foldedX = (1.0f - std::fabs(y)) * (x < 0 ? -1.0f : 1.0f);
+		float foldedY = (1.0f - std::fabs(x)) * (y < 0 ? -1.0f : 1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+	packed[0] = std::int16_t(std::lround(x * 32767.0f));
+	packed[1] = std::int16_t(std::lround(y * 32767.0f));
+}
+
+XMFLOAT3 DecodeOctahedralNormal(const std::int16_t packed[2])
+{
+	// Unfold the octahedron, the same as the planet shader
+	float x = packed[0] / 32767.0f;
+	float y = packed[1] / 32767.0f;
+	float z = 1.0f - std::fabs(x) - std::fabs(y);
+	if (z < 0)
+	{
+		float unfoldedX = (1.0f - std::fabs(y)) * (x < 0 ? -1.0f : 1.0f);
+		float unfoldedY = (1.0f - std::fabs(x)) * (y < 0 ? -1.0f : 1.0f);
+		x = unfoldedX;
+		y = unfoldedY;
+	}
+
+	XMFLOAT3 normal = { x, y, z };
+	Normalize(&normal);
+	return normal;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Utility.h"
+#include <cstdint>
+
+// Compact vertex for planet chunks, 16 bytes against Vertex's 60. The planet shader only reads the
+// position and normal, so the colour, UV and tangent are dropped and the normal is packed
+struct PlanetVertex
+{
+	XMFLOAT3 Pos = XMFLOAT3{ 0,0,0 };
+
+	// Octahedral normal, read as R16G16_SNORM
+	std::int16_t Normal[2] = { 0,0 };
+};
+static_assert(sizeof(PlanetVertex) == 16, "PlanetVertex must match the planet input layout");
+
+// Convert between full and compact vertices. Decoding leaves the colour, UV and tangent at zero
+PlanetVertex EncodePlanetVertex(const Vertex& vertex);
+Vertex DecodePlanetVertex(const PlanetVertex& vertex);
+
+// Pack a unit normal onto an octahedron, folding the lower half over the upper half, and back
+void EncodeOctahedralNormal(XMFLOAT3 normal, std::int16_t packed[2]);
+XMFLOAT3 DecodeOctahedralNormal(const std::int16_t packed[2]);
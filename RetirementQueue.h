@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+// Objects the GPU may still be using, deleted once a fence passes the value they were retired with.
+// Only fence values are used so the queue can be driven by a simulated counter.
+template <typename T>
+class RetirementQueue
+{
+public:
+	~RetirementQueue() { Flush(); }
+
+	// Retire an object that is in use until the GPU reaches fenceValue
+	void Retire(T* object, std::uint64_t fenceValue)
+	{
+		// Fence values only increase, so keep the queue ordered
+		if (!mQueue.empty() && fenceValue < mQueue.back().first) fenceValue = mQueue.back().first;
+		mQueue.push_back({ fenceValue, object });
+	}
+
+	// Delete objects whose fence value has been reached, returns the number deleted
+	int Collect(std::uint64_t completedFence)
+	{
+		int count = 0;
+		while (!mQueue.empty() && mQueue.front().first <= completedFence)
+		{
+			delete mQueue.front().second;
+			mQueue.pop_front();
+			count++;
+		}
+		return count;
+	}
+
+	// Delete everything, only call when the GPU is idle
+	void Flush()
+	{
+		for (auto& retired : mQueue)
+		{
+			delete retired.second;
+		}
+		mQueue.clear();
+	}
+
+	size_t Size() const { return mQueue.size(); }
+
+private:
+	std::deque<std::pair<std::uint64_t, T*>> mQueue;
+};
@@ -1,11 +1,31 @@
 #include "common.hlsl"
 
+#ifdef PACKED_VERTEX
+// Compact chunk vertex, see PlanetVertex.h
+struct VIn
+{
+	float3 PosL : POSITION;
+	float2 PackedNormal : NORMAL;
+};
+
+// Unfold an octahedral normal, as DecodeOctahedralNormal does
+float3 DecodeOctahedralNormal(float2 packed)
+{
+	float3 normal = float3(packed, 1.0f - abs(packed.x) - abs(packed.y));
+	if (normal.z < 0)
+	{
+		normal.xy = (1.0f - abs(packed.yx)) * (packed.xy < 0 ? -1.0f : 1.0f);
+	}
+	return normalize(normal);
+}
+#else
 struct VIn
 {
 	float3 PosL : POSITION;
 	float4 Colour : COLOUR;
 	float3 NormalL : NORMAL;
 };
+#endif
 
 struct VOut
 {
@@ -23,12 +43,21 @@ VOut VS(VIn vin)
 	float4 posW = mul(float4(vin.PosL, 1.0f), World);
 	vout.PosW = posW.xyz;
 	
+#ifdef PACKED_VERTEX
+	vout.NormalW = mul(DecodeOctahedralNormal(vin.PackedNormal), (float3x3)World);
+#else
 	vout.NormalW = mul(vin.NormalL, (float3x3)World);
+#endif
 	
 	vout.PosH = mul(posW, ViewProj);
 	
+#ifdef PACKED_VERTEX
+	// Compact vertices have no colour, the pixel shader colours by elevation
+	vout.Colour = float4(0.0f, 0.0f, 0.0f, 1.0f);
+#else
 	// Pass vertex colour into the pixel shader.
 	vout.Colour = vin.Colour;
+#endif
     
 	return vout;
 }
@@ -37,10 +66,8 @@ float4 PS(VOut pIn) : SV_Target
 {
 	VOut vOut;
 	
-	float3 dx = ddx(pIn.PosW);
-	float3 dy = ddy(pIn.PosW);
-	
-	float3 n = normalize(cross(dx, dy));
+	// Normal from the slope of the noise, smooth across triangles and chunk borders
+	float3 n = normalize(pIn.NormalW);
 	float3 v = normalize(EyePosW - pIn.PosW); // Get normal to camera, called v for view vector in PBR equations
 	
 	// Calculate steepness relative to the up vector
@@ -0,0 +1,161 @@
+#include "Test.h"
+#include "BlockAllocator.h"
+
+#include <random>
+
+TEST(BlockAllocatorAllocateAndFree)
+{
+	BlockAllocator allocator(1 << 16);
+
+	// Sizes round up to the smallest block and offsets honour the alignment
+	BlockAllocator::Allocation a, b;
+	CHECK(allocator.Allocate(10, 16, a));
+	CHECK(a.IsValid() && a.Size >= 10 && a.Offset % 16 == 0);
+	CHECK(allocator.Allocate(1000, 256, b));
+	CHECK(b.Offset % 256 == 0 && b.Offset + b.Size <= allocator.Capacity());
+	CHECK(b.Offset >= a.Offset + a.Size || a.Offset >= b.Offset + b.Size);
+
+	auto stats = allocator.GetStats();
+	CHECK(stats.NumAllocations == 2 && stats.UsedBytes == a.Size + b.Size);
+	CHECK(stats.UsedBytes + stats.FreeBytes == stats.Capacity);
+
+	// Too large for the capacity
+	BlockAllocator::Allocation c;
+	CHECK(!allocator.Allocate(1 << 17, 16, c));
+	CHECK(!c.IsValid());
+
+	// Freeing resets the allocation and leaves one free block
+	allocator.Free(a);
+	allocator.Free(b);
+	CHECK(!a.IsValid() && !b.IsValid());
+	CHECK(allocator.IsEmpty());
+	stats = allocator.GetStats();
+	CHECK(stats.NumFreeBlocks == 1 && stats.LargestFreeBlock == allocator.Capacity());
+}
+
+TEST(BlockAllocatorCoalesce)
+{
+	// Eight blocks filling the allocator
+	BlockAllocator allocator(1024);
+	BlockAllocator::Allocation blocks[8];
+	for (auto& block : blocks) CHECK(allocator.Allocate(128, 16, block));
+
+	// Two separate holes are two free blocks, and neither holds a larger allocation
+	allocator.Free(blocks[1]);
+	allocator.Free(blocks[3]);
+	auto stats = allocator.GetStats();
+	CHECK(stats.NumFreeBlocks == 2 && stats.FreeBytes == 256 && stats.LargestFreeBlock == 128);
+	CHECK_NEAR(stats.Fragmentation(), 0.5f, 1e-6f);
+	BlockAllocator::Allocation large;
+	CHECK(!allocator.Allocate(200, 16, large));
+
+	// Freeing the block between them merges all three
+	allocator.Free(blocks[2]);
+	stats = allocator.GetStats();
+	CHECK(stats.NumFreeBlocks == 1 && stats.LargestFreeBlock == 384);
+	CHECK(stats.Fragmentation() == 0);
+	CHECK(allocator.Allocate(384, 16, large) && large.Offset == 128);
+
+	// Freeing everything merges back into one block
+	allocator.Free(large);
+	for (auto& block : blocks)
+	{
+		if (block.IsValid()) allocator.Free(block);
+	}
+	stats = allocator.GetStats();
+	CHECK(allocator.IsEmpty() && stats.NumFreeBlocks == 1 && stats.LargestFreeBlock == 1024);
+}
+
+TEST(BlockAllocatorRandomAgainstReference)
+{
+	// Random allocations and frees, as meshes come and go, checked against a flag per byte
+	std::mt19937_64 random(25);
+	for (int trial = 0; trial < 5; trial++)
+	{
+		std::uint64_t capacity = (1 << 20) | (random() % 4096) * 16;
+		BlockAllocator allocator(capacity);
+		std::vector<BlockAllocator::Allocation> live;
+		std::vector<bool> used(capacity, false);
+		bool inRange = true, overlapped = false, missedRoom = false, statsWrong = false;
+
+		for (int op = 0; op < 20000; op++)
+		{
+			if (live.empty() || random() % 3)
+			{
+				std::uint64_t size = 1 + random() % (random() % 2 ? 200 : 40000);
+				std::uint64_t alignment = 1ull << (random() % 9);
+				BlockAllocator::Allocation allocation;
+				if (allocator.Allocate(size, alignment, allocation))
+				{
+					inRange &= allocation.Offset % alignment == 0 && allocation.Size >= size && allocation.Offset + allocation.Size <= capacity;
+					for (auto i = allocation.Offset; i < allocation.Offset + allocation.Size; i++)
+					{
+						overlapped |= used[i];
+						used[i] = true;
+					}
+					live.push_back(allocation);
+				}
+				else
+				{
+					// Only fails when no free block could hold it after rounding and alignment, with the slack
+					// of the size class searched
+					std::uint64_t need = ((size + 15) & ~15ull) + (alignment < 16 ? 16 : alignment) - 16;
+					missedRoom |= allocator.GetStats().LargestFreeBlock >= need + need / 16 + 16;
+				}
+			}
+			else
+			{
+				auto index = random() % live.size();
+				auto allocation = live[index];
+				live[index] = live.back();
+				live.pop_back();
+				for (auto i = allocation.Offset; i < allocation.Offset + allocation.Size; i++) used[i] = false;
+				allocator.Free(allocation);
+			}
+
+			if (op % 97 == 0)
+			{
+				std::uint64_t usedBytes = 0;
+				for (auto& allocation : live) usedBytes += allocation.Size;
+				auto stats = allocator.GetStats();
+				statsWrong |= stats.UsedBytes != usedBytes || stats.NumAllocations != live.size() || stats.FreeBytes + stats.UsedBytes != capacity;
+			}
+		}
+		CHECK(inRange);
+		CHECK(!overlapped);
+		CHECK(!missedRoom);
+		CHECK(!statsWrong);
+
+		// Everything merges back once freed
+		for (auto& allocation : live) allocator.Free(allocation);
+		auto stats = allocator.GetStats();
+		CHECK(allocator.IsEmpty() && stats.NumFreeBlocks == 1 && stats.LargestFreeBlock == capacity);
+	}
+}
+
+TEST(BlockAllocatorBenchmark)
+{
+	// Chunk sized allocations cycling through a full heap, as chunks split and merge
+	BlockAllocator allocator(64ull << 20);
+	std::mt19937 random(25);
+	std::vector<BlockAllocator::Allocation> live(4000);
+	int operations = 0;
+	auto time = TimeMilliseconds([&]
+	{
+		for (auto& allocation : live) allocator.Allocate(16384 + random() % 65536, 16, allocation);
+		for (int i = 0; i < 100000; i++)
+		{
+			auto& allocation = live[random() % live.size()];
+			if (allocation.IsValid()) allocator.Free(allocation);
+			allocator.Allocate(16384 + random() % 65536, 16, allocation);
+		}
+		for (auto& allocation : live)
+		{
+			if (allocation.IsValid()) allocator.Free(allocation);
+		}
+		operations = 2 * 100000 + 2 * int(live.size());
+	}, 3);
+	auto stats = allocator.GetStats();
+	std::printf("  %.1f ns per allocate or free\n", time * 1e6 / operations);
+	CHECK(allocator.IsEmpty() && stats.NumFreeBlocks == 1);
+}
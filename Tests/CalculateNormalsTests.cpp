@@ -0,0 +1,129 @@
+#include "Test.h"
+#include "Utility.h"
+
+#include <atomic>
+
+TEST(CalculateNormalsPointOutOfIcosahedron)
+{
+	// Base icosahedron of the planet, with the engine's winding
+	const float X = 0.525731112119133606f;
+	const float Z = 0.850650808352039932f;
+	const float N = 0.0f;
+	XMFLOAT3 positions[] =
+	{
+		{-X,N,Z}, {X,N,Z}, {-X,N,-Z}, {X,N,-Z}, {N,Z,X}, {N,Z,-X},
+		{N,-Z,X}, {N,-Z,-X}, {Z,X,N}, {-Z,X,N}, {Z,-X,N}, {-Z,-X,N}
+	};
+	std::vector<uint32_t> indices =
+	{
+		1,4,0,	4,9,0,	4,5,9,	8,5,4,	1,8,4,	1,10,8,	10,3,8, 8,3,5,	3,2,5,	3,7,2,
+		3,10,7,	10,6,7,	6,11,7,	6,0,11,	6,1,0,	10,1,6,	11,0,9,	2,11,9,	5,2,9,	11,2,7
+	};
+	std::vector<Vertex> vertices(12);
+	for (int i = 0; i < 12; i++) vertices[i].Pos = positions[i];
+
+	// Every vertex is alike, so its smooth normal points straight out
+	std::vector<XMFLOAT3> normals(vertices.size());
+	CalculateNormals(vertices, indices, normals);
+	for (int i = 0; i < 12; i++)
+	{
+		CHECK_NEAR(DotProduct(normals[i], positions[i]), 1.0f, 1e-5f);
+	}
+}
+
+TEST(CalculateNormalsLeavesUnusedVerticesAtZero)
+{
+	std::vector<Vertex> vertices(4);
+	vertices[0].Pos = { 0,0,0 };
+	vertices[1].Pos = { 1,0,0 };
+	vertices[2].Pos = { 0,1,0 };
+	vertices[3].Pos = { 5,5,5 };
+	std::vector<uint32_t> indices = { 0, 1, 2 };
+	std::vector<XMFLOAT3> normals(vertices.size(), { 9,9,9 });
+	CalculateNormals(vertices, indices, normals);
+	CHECK_NEAR(std::abs(normals[0].z), 1.0f, 1e-6f);
+	CHECK(normals[3].x == 0 && normals[3].y == 0 && normals[3].z == 0);
+}
+
+namespace
+{
+	// Grid of triangles over a bumpy height field, shared vertices get normals from several triangle ranges
+	void BuildGrid(int size, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		vertices.resize(size_t(size) * size);
+		for (int y = 0; y < size; y++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				vertices[y * size + x].Pos = { float(x), float(y), std::sin(x * 0.3f) * std::cos(y * 0.2f) * 4 };
+			}
+		}
+		indices.clear();
+		for (int y = 0; y + 1 < size; y++)
+		{
+			for (int x = 0; x + 1 < size; x++)
+			{
+				uint32_t i = y * size + x;
+				indices.insert(indices.end(), { i, i + 1, i + size, i + 1, i + size + 1, i + size });
+			}
+		}
+	}
+}
+
+TEST(CalculateNormalsParallelMatchesSerial)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	BuildGrid(300, vertices, indices);
+
+	std::vector<XMFLOAT3> serial(vertices.size());
+	CalculateNormals(vertices, indices, serial);
+
+	// Enough scratch for every worker, for some of them, and for none
+	ThreadPool pool(4);
+	for (size_t slices : { 4, 2, 0 })
+	{
+		std::vector<XMFLOAT3> parallel(vertices.size(), { 9,9,9 });
+		std::vector<XMFLOAT3> scratch(vertices.size() * slices);
+		CalculateNormals(vertices, indices, parallel, scratch, pool);
+		float worst = 0;
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			auto difference = Distance(parallel[i], serial[i]);
+			if (difference > worst) worst = difference;
+		}
+		CHECK(worst < 1e-5f);
+	}
+}
+
+TEST(CalculateNormalsParallelBenchmark)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	BuildGrid(1000, vertices, indices);
+	std::vector<XMFLOAT3> normals(vertices.size());
+
+	ThreadPool pool;
+	std::vector<XMFLOAT3> scratch(vertices.size() * pool.NumThreads());
+	auto serialTime = TimeMilliseconds([&] { CalculateNormals(vertices, indices, normals); });
+	auto parallelTime = TimeMilliseconds([&] { CalculateNormals(vertices, indices, normals, scratch, pool); });
+	std::printf("  %zu vertices: serial %.2f ms, %d workers %.2f ms\n", vertices.size(), serialTime, pool.NumThreads(), parallelTime);
+}
+
+TEST(ThreadPoolParallelForWhileBusy)
+{
+	// Every task runs once, even while a job holds the only worker
+	ThreadPool pool(1);
+	std::atomic<bool> release = false;
+	pool.AddJob([&] { while (!release) std::this_thread::yield(); });
+
+	std::vector<int> counts(64, 0);
+	auto task = [&](int index) { counts[index]++; };
+	pool.ParallelFor(int(counts.size()), task);
+	release = true;
+	pool.Wait();
+
+	bool once = true;
+	for (auto count : counts) once &= count == 1;
+	CHECK(once);
+}
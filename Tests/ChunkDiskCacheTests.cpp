@@ -0,0 +1,204 @@
+#include "Test.h"
+#include "ChunkDiskCache.h"
+#include "PlanetSurface.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	const ChunkDiskParams PARAMS = { 1337, 0.5f, 8, 45 };
+	const int NUM_RECORDS = 6;
+
+	// Empty directory for a test's cache files
+	std::string GetTestDirectory(const char* name)
+	{
+		auto directory = std::filesystem::temp_directory_path() / "ChunkDiskCacheTests" / name;
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+		return directory.string();
+	}
+
+	// The cache file in a directory, each test only writes one parameter set at a time
+	std::filesystem::path GetCacheFile(const std::string& directory)
+	{
+		for (auto& entry : std::filesystem::directory_iterator(directory))
+		{
+			if (entry.path().extension() == ".chunks") return entry.path();
+		}
+		return {};
+	}
+
+	// Vertices of a chunk whose heights depend on its path, so records can be told apart
+	std::vector<PlanetVertex> MakeChunk(std::uint64_t path, int numVertices)
+	{
+		std::vector<PlanetVertex> vertices(numVertices);
+		for (int i = 0; i < numVertices; i++)
+		{
+			float height = 1 + PlanetSurface::MAX_ELEVATION * (float((path * 7 + i) % 19) / 19.0f - 0.5f);
+			vertices[i].Pos = { height, 0, 0 };
+			vertices[i].Normal[0] = std::int16_t(path);
+			vertices[i].Normal[1] = std::int16_t(i);
+		}
+		return vertices;
+	}
+
+	// Does the cache hold a chunk's record with the vertices it was saved with
+	bool HasChunk(ChunkDiskCache& cache, std::uint64_t path, int numVertices)
+	{
+		auto packed = cache.Find(path);
+		if (!packed) return false;
+		auto vertices = MakeChunk(path, numVertices);
+		for (int i = 0; i < numVertices; i++)
+		{
+			auto height = vertices[i].Pos.x - 1;
+			if (std::abs(ChunkDiskCache::DecodeHeight(packed[i]) - height) > 1e-4f) return false;
+			if (packed[i].Normal[0] != vertices[i].Normal[0] || packed[i].Normal[1] != vertices[i].Normal[1]) return false;
+		}
+		return true;
+	}
+
+	// Write a file of records, returning the header and record sizes seen in the file
+	void WriteRecords(const std::string& directory, const ChunkDiskParams& params, std::uintmax_t& headerSize, std::uintmax_t& recordSize)
+	{
+		ChunkDiskCache cache;
+		CHECK(cache.Open(directory, params));
+		cache.Flush();
+		headerSize = std::filesystem::file_size(GetCacheFile(directory));
+		for (std::uint64_t path = 0; path < NUM_RECORDS; path++) cache.Append(path, MakeChunk(path, params.NumVertices));
+		cache.Close();
+		recordSize = (std::filesystem::file_size(GetCacheFile(directory)) - headerSize) / NUM_RECORDS;
+	}
+
+	// Overwrite bytes of a file in place
+	void PatchFile(const std::filesystem::path& file, std::uintmax_t offset, const void* data, size_t size)
+	{
+		std::fstream stream(file, std::ios::in | std::ios::out | std::ios::binary);
+		stream.seekp(std::streamoff(offset));
+		stream.write(static_cast<const char*>(data), std::streamsize(size));
+	}
+}
+
+TEST(ChunkDiskCacheReloads)
+{
+	auto directory = GetTestDirectory("Reloads");
+	std::uintmax_t headerSize, recordSize;
+	WriteRecords(directory, PARAMS, headerSize, recordSize);
+	CHECK(recordSize > 0);
+
+	// Every record comes back in the next session, and a second append of one is ignored
+	ChunkDiskCache cache;
+	CHECK(cache.Open(directory, PARAMS));
+	for (std::uint64_t path = 0; path < NUM_RECORDS; path++) CHECK(HasChunk(cache, path, PARAMS.NumVertices));
+	CHECK(!cache.Find(NUM_RECORDS));
+	cache.Append(0, MakeChunk(0, PARAMS.NumVertices));
+	cache.Close();
+	CHECK(std::filesystem::file_size(GetCacheFile(directory)) == headerSize + recordSize * NUM_RECORDS);
+}
+
+TEST(ChunkDiskCacheTruncatedFile)
+{
+	auto directory = GetTestDirectory("Truncated");
+	std::uintmax_t headerSize, recordSize;
+	WriteRecords(directory, PARAMS, headerSize, recordSize);
+
+	// Cut the file off half way through the fourth record, as a crash while writing would
+	auto file = GetCacheFile(directory);
+	std::filesystem::resize_file(file, headerSize + recordSize * 3 + recordSize / 2);
+
+	// The whole records load, the partial one is dropped and cut from the file
+	{
+		ChunkDiskCache cache;
+		CHECK(cache.Open(directory, PARAMS));
+		for (std::uint64_t path = 0; path < 3; path++) CHECK(HasChunk(cache, path, PARAMS.NumVertices));
+		for (std::uint64_t path = 3; path < NUM_RECORDS; path++) CHECK(!cache.Find(path));
+		CHECK(std::filesystem::file_size(file) == headerSize + recordSize * 3);
+
+		// Rebuilt chunks are saved after the valid records
+		cache.Append(3, MakeChunk(3, PARAMS.NumVertices));
+	}
+	ChunkDiskCache cache;
+	CHECK(cache.Open(directory, PARAMS));
+	for (std::uint64_t path = 0; path < 4; path++) CHECK(HasChunk(cache, path, PARAMS.NumVertices));
+}
+
+TEST(ChunkDiskCacheCorruptChecksum)
+{
+	auto directory = GetTestDirectory("Corrupt");
+	std::uintmax_t headerSize, recordSize;
+	WriteRecords(directory, PARAMS, headerSize, recordSize);
+
+	// Flip a byte of the third record's vertices
+	auto file = GetCacheFile(directory);
+	std::uint8_t garbage = 0x5a;
+	PatchFile(file, headerSize + recordSize * 2 + recordSize / 2, &garbage, 1);
+
+	// Records before it load, it and everything after are dropped and can be saved again
+	{
+		ChunkDiskCache cache;
+		CHECK(cache.Open(directory, PARAMS));
+		for (std::uint64_t path = 0; path < 2; path++) CHECK(HasChunk(cache, path, PARAMS.NumVertices));
+		for (std::uint64_t path = 2; path < NUM_RECORDS; path++) CHECK(!cache.Find(path));
+		CHECK(std::filesystem::file_size(file) == headerSize + recordSize * 2);
+		cache.Append(2, MakeChunk(2, PARAMS.NumVertices));
+	}
+	ChunkDiskCache cache;
+	CHECK(cache.Open(directory, PARAMS));
+	CHECK(HasChunk(cache, 2, PARAMS.NumVertices));
+}
+
+TEST(ChunkDiskCacheStaleHeader)
+{
+	// A file whose header was written for other settings, under the name of this planet's file, is started again
+	ChunkDiskParams others[] =
+	{
+		{ PARAMS.Seed + 1, PARAMS.Frequency, PARAMS.Octaves, PARAMS.NumVertices },
+		{ PARAMS.Seed, PARAMS.Frequency * 2, PARAMS.Octaves, PARAMS.NumVertices },
+		{ PARAMS.Seed, PARAMS.Frequency, PARAMS.Octaves + 1, PARAMS.NumVertices },
+	};
+	for (auto& other : others)
+	{
+		auto directory = GetTestDirectory("Stale");
+		std::uintmax_t headerSize, recordSize;
+		WriteRecords(directory, other, headerSize, recordSize);
+		auto staleFile = GetCacheFile(directory);
+		auto staleCopy = staleFile.string() + ".stale";
+		std::filesystem::rename(staleFile, staleCopy);
+
+		// Create this planet's file, then replace it with the stale one
+		{
+			ChunkDiskCache cache;
+			CHECK(cache.Open(directory, PARAMS));
+		}
+		auto file = GetCacheFile(directory);
+		std::filesystem::rename(staleCopy, file);
+
+		{
+			ChunkDiskCache cache;
+			CHECK(cache.Open(directory, PARAMS));
+			for (std::uint64_t path = 0; path < NUM_RECORDS; path++) CHECK(!cache.Find(path));
+			CHECK(std::filesystem::file_size(file) == headerSize);
+			cache.Append(1, MakeChunk(1, PARAMS.NumVertices));
+		}
+		ChunkDiskCache cache;
+		CHECK(cache.Open(directory, PARAMS));
+		CHECK(HasChunk(cache, 1, PARAMS.NumVertices));
+	}
+}
+
+TEST(ChunkDiskCacheVersionMismatch)
+{
+	auto directory = GetTestDirectory("Version");
+	std::uintmax_t headerSize, recordSize;
+	WriteRecords(directory, PARAMS, headerSize, recordSize);
+
+	// The version follows the magic number at the start of the header
+	auto file = GetCacheFile(directory);
+	std::uint32_t oldVersion = 1;
+	PatchFile(file, sizeof(std::uint32_t), &oldVersion, sizeof(oldVersion));
+
+	ChunkDiskCache cache;
+	CHECK(cache.Open(directory, PARAMS));
+	for (std::uint64_t path = 0; path < NUM_RECORDS; path++) CHECK(!cache.Find(path));
+	CHECK(std::filesystem::file_size(file) == headerSize);
+}
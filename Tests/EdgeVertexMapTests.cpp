@@ -0,0 +1,188 @@
+#include "Test.h"
+#include "../EdgeVertexMap.h"
+#include <atomic>
+#include <map>
+#include <thread>
+
+namespace
+{
+	struct Position
+	{
+		float x, y, z;
+	};
+
+	struct Face
+	{
+		uint32_t Point[3];
+	};
+
+	// Base icosahedron, as the planet starts from
+	std::vector<Position> IcosahedronVertices()
+	{
+		const float X = 0.525731112119133606f;
+		const float Z = 0.850650808352039932f;
+		return { {-X,0,Z}, {X,0,Z}, {-X,0,-Z}, {X,0,-Z}, {0,Z,X}, {0,Z,-X}, {0,-Z,X}, {0,-Z,-X}, {Z,X,0}, {-Z,X,0}, {Z,-X,0}, {-Z,-X,0} };
+	}
+
+	std::vector<Face> IcosahedronFaces()
+	{
+		return { {1,4,0}, {4,9,0}, {4,5,9}, {8,5,4}, {1,8,4}, {1,10,8}, {10,3,8}, {8,3,5}, {3,2,5}, {3,7,2},
+			{3,10,7}, {10,6,7}, {6,11,7}, {6,0,11}, {6,1,0}, {10,1,6}, {11,0,9}, {2,11,9}, {5,2,9}, {11,2,7} };
+	}
+
+	Position Midpoint(const Position& a, const Position& b)
+	{
+		Position mid = { a.x + b.x, a.y + b.y, a.z + b.z };
+		float length = std::sqrt(mid.x * mid.x + mid.y * mid.y + mid.z * mid.z);
+		return { mid.x / length, mid.y / length, mid.z / length };
+	}
+
+	// Split every face into four to a level, getting midpoints from the edge lookup
+	template <typename GetMidpoint>
+	std::vector<Face> Subdivide(std::vector<Face> faces, int levels, GetMidpoint&& getMidpoint)
+	{
+		std::vector<Face> next;
+		for (int level = 0; level < levels; level++)
+		{
+			next.clear();
+			for (auto& face : faces)
+			{
+				uint32_t mid[3];
+				for (int i = 0; i < 3; i++) mid[i] = getMidpoint(face.Point[i], face.Point[(i + 1) % 3]);
+				next.push_back({ face.Point[0], mid[0], mid[2] });
+				next.push_back({ face.Point[1], mid[1], mid[0] });
+				next.push_back({ face.Point[2], mid[2], mid[1] });
+				next.push_back({ mid[0], mid[1], mid[2] });
+			}
+			std::swap(faces, next);
+		}
+		return faces;
+	}
+
+	// Vertices of an icosahedron subdivided to a level
+	size_t VerticesAtLevel(int level) { return 10 * (size_t(1) << (2 * level)) + 2; }
+	size_t EdgesAtLevel(int level) { return 30 * (size_t(1) << (2 * level)); }
+}
+
+TEST(EdgeVertexMapSharesMidpoints)
+{
+	for (int level = 1; level <= 4; level++)
+	{
+		auto vertices = IcosahedronVertices();
+		EdgeVertexMap map;
+		map.Reserve(EdgesAtLevel(level));
+		auto faces = Subdivide(IcosahedronFaces(), level, [&](uint32_t v1, uint32_t v2)
+		{
+			return uint32_t(map.GetOrCreate(v1, v2, [&]()
+			{
+				vertices.push_back(Midpoint(vertices[v1], vertices[v2]));
+				return int(vertices.size() - 1);
+			}));
+		});
+
+		// Every edge made exactly one vertex, which either face of the edge finds
+		CHECK(vertices.size() == VerticesAtLevel(level));
+		CHECK(faces.size() == 20 * (size_t(1) << (2 * level)));
+		CHECK(map.Find(0, 1) == map.Find(1, 0));
+	}
+}
+
+TEST(EdgeVertexMapEraseKeepsOtherEdges)
+{
+	EdgeVertexMap map(64);
+	for (uint32_t i = 0; i < 40; i++) map.GetOrCreate(i, i + 1, [&]() { return int(i); });
+
+	// Removing edges must not hide edges later in the same probe run
+	for (uint32_t i = 0; i < 40; i += 2) CHECK(map.Erase(i + 1, i));
+	for (uint32_t i = 0; i < 40; i++) CHECK(map.Find(i, i + 1) == (i % 2 ? int(i) : -1));
+	CHECK(map.Size() == 20);
+}
+
+TEST(EdgeVertexMapConcurrentInserts)
+{
+	// Threads subdivide neighbouring faces at once, so shared edges are raced for. Vertex slots are
+	// reserved up front and handed out with an atomic index, the edge table makes one per edge
+	const int level = 5;
+	const int numThreads = 4;
+	auto baseVertices = IcosahedronVertices();
+	std::vector<Position> vertices(VerticesAtLevel(level));
+	std::copy(baseVertices.begin(), baseVertices.end(), vertices.begin());
+	std::atomic<uint32_t> nextVertex = uint32_t(baseVertices.size());
+
+	EdgeVertexMap map;
+	map.Reserve(EdgesAtLevel(level));
+	auto faces = IcosahedronFaces();
+
+	std::vector<std::thread> threads;
+	for (int thread = 0; thread < numThreads; thread++)
+	{
+		threads.emplace_back([&, thread]()
+		{
+			std::vector<Face> ownFaces;
+			for (size_t face = thread; face < faces.size(); face += numThreads) ownFaces.push_back(faces[face]);
+			Subdivide(ownFaces, level, [&](uint32_t v1, uint32_t v2)
+			{
+				return uint32_t(map.GetOrCreate(v1, v2, [&]()
+				{
+					// Ends are complete before their edge can be looked up
+					auto vertex = nextVertex.fetch_add(1);
+					vertices[vertex] = Midpoint(vertices[v1], vertices[v2]);
+					return int(vertex);
+				}));
+			});
+		});
+	}
+	for (auto& thread : threads) thread.join();
+
+	CHECK(nextVertex.load() == VerticesAtLevel(level));
+	CHECK(map.Size() == VerticesAtLevel(level) - baseVertices.size());
+	for (auto& vertex : vertices)
+	{
+		CHECK_NEAR(vertex.x * vertex.x + vertex.y * vertex.y + vertex.z * vertex.z, 1.0, 1e-4);
+	}
+}
+
+TEST(EdgeVertexMapBenchmark)
+{
+	// Subdivide the whole icosahedron at the levels the planet reaches, against the std::map lookup it replaced
+	for (int level = 4; level <= 6; level++)
+	{
+		size_t tableVertices = 0, mapVertices = 0;
+		double tableTime = TimeMilliseconds([&]()
+		{
+			auto vertices = IcosahedronVertices();
+			vertices.reserve(VerticesAtLevel(level));
+			EdgeVertexMap map;
+			map.Reserve(EdgesAtLevel(level));
+			Subdivide(IcosahedronFaces(), level, [&](uint32_t v1, uint32_t v2)
+			{
+				return uint32_t(map.GetOrCreate(v1, v2, [&]()
+				{
+					vertices.push_back(Midpoint(vertices[v1], vertices[v2]));
+					return int(vertices.size() - 1);
+				}));
+			});
+			tableVertices = vertices.size();
+		});
+
+		double mapTime = TimeMilliseconds([&]()
+		{
+			auto vertices = IcosahedronVertices();
+			vertices.reserve(VerticesAtLevel(level));
+			std::map<std::pair<uint32_t, uint32_t>, uint32_t> map;
+			Subdivide(IcosahedronFaces(), level, [&](uint32_t v1, uint32_t v2)
+			{
+				auto edge = v1 < v2 ? std::make_pair(v1, v2) : std::make_pair(v2, v1);
+				auto found = map.find(edge);
+				if (found != map.end()) return found->second;
+				vertices.push_back(Midpoint(vertices[v1], vertices[v2]));
+				map[edge] = uint32_t(vertices.size() - 1);
+				return uint32_t(vertices.size() - 1);
+			});
+			mapVertices = vertices.size();
+		});
+
+		CHECK(tableVertices == mapVertices);
+		std::printf("  LOD %d: %zu vertices, edge table %.2f ms, std::map %.2f ms\n", level, tableVertices, tableTime, mapTime);
+	}
+}
@@ -0,0 +1,171 @@
+#include "Test.h"
+#include "MappedBuffer.h"
+#include "Utility.h"
+
+#include <random>
+
+namespace
+{
+	// Elements marked by a set of intervals, for comparing against a plain array of flags
+	std::vector<bool> MarkedElements(const DirtyIntervals& dirty, std::uint32_t size)
+	{
+		std::vector<bool> marked(size, false);
+		for (auto& interval : dirty.Intervals())
+		{
+			for (auto i = interval.First; i < interval.First + interval.Count; i++) marked[i] = true;
+		}
+		return marked;
+	}
+
+	// Intervals are sorted, non empty and neither overlap nor touch
+	bool IsMerged(const DirtyIntervals& dirty)
+	{
+		auto& intervals = dirty.Intervals();
+		for (size_t i = 0; i < intervals.size(); i++)
+		{
+			if (intervals[i].Count == 0) return false;
+			if (i > 0 && intervals[i - 1].First + intervals[i - 1].Count >= intervals[i].First) return false;
+		}
+		return true;
+	}
+}
+
+TEST(DirtyIntervalsMerge)
+{
+	DirtyIntervals dirty;
+	dirty.Add(10, 5);
+	dirty.Add(30, 5);
+	dirty.Add(0, 0);
+	CHECK(dirty.Intervals().size() == 2);
+
+	// Touching ranges join, [10,15) and [15,20)
+	dirty.Add(15, 5);
+	CHECK(dirty.Intervals().size() == 2);
+	CHECK(dirty.Intervals()[0].First == 10 && dirty.Intervals()[0].Count == 10);
+	dirty.Add(25, 5);
+	CHECK(dirty.Intervals().size() == 2);
+	CHECK(dirty.Intervals()[1].First == 25 && dirty.Intervals()[1].Count == 10);
+
+	// A range over both swallows them
+	dirty.Add(5, 40);
+	CHECK(dirty.Intervals().size() == 1);
+	CHECK(dirty.Intervals()[0].First == 5 && dirty.Intervals()[0].Count == 40);
+
+	// One inside changes nothing
+	dirty.Add(20, 3);
+	CHECK(dirty.Intervals().size() == 1);
+	CHECK(dirty.Intervals()[0].First == 5 && dirty.Intervals()[0].Count == 40);
+
+	dirty.Clear();
+	CHECK(dirty.Empty());
+}
+
+TEST(DirtyIntervalsRandomMarks)
+{
+	// Random marks, as chunks are added and removed, match a flag per element
+	const std::uint32_t size = 5000;
+	std::mt19937 random(23);
+	DirtyIntervals dirty, sibling;
+	std::vector<bool> expected(size, false);
+	for (int i = 0; i < 2000; i++)
+	{
+		std::uint32_t first = random() % size;
+		std::uint32_t count = random() % 40;
+		if (first + count > size) count = size - first;
+		dirty.Add(first, count);
+		for (auto e = first; e < first + count; e++) expected[e] = true;
+
+		// Catching up a sibling buffer gives the same set
+		if (i % 100 == 99)
+		{
+			sibling.Add(dirty);
+			CHECK(sibling.Intervals().size() == dirty.Intervals().size());
+		}
+	}
+	CHECK(IsMerged(dirty));
+	CHECK(MarkedElements(dirty, size) == expected);
+}
+
+TEST(MappedBufferWriteAndFlush)
+{
+	std::vector<std::uint32_t> source(100);
+	for (std::uint32_t i = 0; i < source.size(); i++) source[i] = i + 1;
+
+	std::vector<std::uint8_t> memory(100 * sizeof(std::uint32_t), 0);
+	MappedBuffer<std::uint32_t> buffer(memory.data(), 100);
+	auto element = [&](int i) { return reinterpret_cast<std::uint32_t*>(memory.data())[i]; };
+
+	// Only the dirty ranges are copied, and they are cleared
+	buffer.MarkDirty(5, 10);
+	buffer.MarkDirty(50, 2);
+	buffer.Flush(source);
+	CHECK(element(4) == 0 && element(5) == 6 && element(14) == 15 && element(15) == 0);
+	CHECK(element(50) == 51 && element(51) == 52 && element(52) == 0);
+	CHECK(buffer.GetDirty().Empty());
+
+	// Ranges past the end of a shrunk source are dropped
+	buffer.MarkDirty(60, 20);
+	buffer.Flush(std::span<const std::uint32_t>(source).first(65));
+	CHECK(element(64) == 65 && element(65) == 0);
+
+	// Everything is copied after MarkAllDirty
+	buffer.MarkAllDirty();
+	buffer.Flush(source);
+	CHECK(element(0) == 1 && element(99) == 100);
+
+	// Writes past the end throw rather than overrun the mapping
+	bool threw = false;
+	try
+	{
+		buffer.Write(95, std::span<const std::uint32_t>(source).first(10));
+	}
+	catch (const std::runtime_error&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+}
+
+TEST(MappedBufferPaddedElements)
+{
+	// Constant buffer elements are padded to 256 bytes, so writes land on that stride
+	const std::uint32_t stride = 256;
+	std::vector<std::uint8_t> memory(8 * stride, 0xff);
+	MappedBuffer<XMFLOAT4> buffer(memory.data(), 8, stride);
+
+	std::vector<XMFLOAT4> data = { { 1,2,3,4 }, { 5,6,7,8 }, { 9,10,11,12 } };
+	buffer.Write(2, data);
+	for (int i = 0; i < 3; i++)
+	{
+		auto written = reinterpret_cast<XMFLOAT4*>(&memory[(2 + i) * stride]);
+		CHECK(written->x == data[i].x && written->w == data[i].w);
+	}
+
+	// The padding and other elements are left alone
+	CHECK(memory[2 * stride + sizeof(XMFLOAT4)] == 0xff);
+	CHECK(memory[1 * stride] == 0xff && memory[5 * stride] == 0xff);
+}
+
+TEST(MappedBufferBulkWriteBenchmark)
+{
+	// A planet's worth of vertices written in bulk against one at a time
+	const std::uint32_t count = 200000;
+	std::vector<Vertex> vertices(count);
+	for (std::uint32_t i = 0; i < count; i++) vertices[i].Pos = { float(i), 0, 0 };
+	std::vector<std::uint8_t> memory(size_t(count) * sizeof(Vertex));
+	MappedBuffer<Vertex> buffer(memory.data(), count);
+
+	auto bulkTime = TimeMilliseconds([&] { buffer.Write(0, vertices); });
+	auto elementTime = TimeMilliseconds([&] { for (std::uint32_t i = 0; i < count; i++) buffer.Copy(int(i), vertices[i]); });
+
+	// Flushing a few changed chunks against rewriting the whole buffer
+	std::mt19937 random(23);
+	auto flushTime = TimeMilliseconds([&]
+	{
+		for (int i = 0; i < 20; i++) buffer.MarkDirty(random() % (count - 1000), 1000);
+		buffer.Flush(vertices);
+	});
+	std::printf("  %u vertices: bulk write %.3f ms, one at a time %.3f ms, flushing 20 chunks %.3f ms\n",
+		count, bulkTime, elementTime, flushTime);
+	CHECK(reinterpret_cast<Vertex*>(memory.data())[count - 1].Pos.x == float(count - 1));
+}
@@ -0,0 +1,154 @@
+#include "Test.h"
+#include "NodeCheckQueue.h"
+#include "Utility.h"
+
+#include <random>
+
+namespace
+{
+	// Nodes with a centre and the distance they switch between split and merged at
+	struct TestNodes
+	{
+		std::vector<XMFLOAT3> Centres;
+		std::vector<float> Thresholds;
+	};
+
+	TestNodes MakeNodes(size_t count)
+	{
+		std::mt19937 random(17);
+		std::uniform_real_distribution<float> unit(-1, 1);
+		std::uniform_real_distribution<float> threshold(0.01f, 2.0f);
+		TestNodes nodes;
+		for (size_t i = 0; i < count; i++)
+		{
+			XMFLOAT3 centre = { unit(random), unit(random), unit(random) };
+			Normalize(&centre);
+			nodes.Centres.push_back(centre);
+			nodes.Thresholds.push_back(threshold(random));
+		}
+		return nodes;
+	}
+
+	// Camera coming down from orbit and flying low over the surface
+	std::vector<XMFLOAT3> MakeCameraPath(int frames)
+	{
+		std::vector<XMFLOAT3> path;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			float t = float(frame) / frames;
+			float altitude = 4.0f - 2.9f * (t < 0.5f ? t * 2 : 1);
+			float angle = t * 3.0f;
+			path.push_back({ altitude * cosf(angle), 0.3f * sinf(angle * 2), altitude * sinf(angle) });
+		}
+		return path;
+	}
+
+	// Node changes found each frame, as pairs of frame and node
+	typedef std::vector<std::pair<int, uint32_t>> Decisions;
+
+	// Check every node every frame, as refinement did before the queue
+	Decisions RunSweep(const TestNodes& nodes, const std::vector<XMFLOAT3>& path)
+	{
+		Decisions decisions;
+		std::vector<bool> inside(nodes.Centres.size(), false);
+		for (int frame = 0; frame < int(path.size()); frame++)
+		{
+			for (uint32_t node = 0; node < nodes.Centres.size(); node++)
+			{
+				bool isInside = Distance(path[frame], nodes.Centres[node]) < nodes.Thresholds[node];
+				if (isInside == inside[node]) continue;
+				inside[node] = isInside;
+				decisions.push_back({ frame, node });
+			}
+		}
+		return decisions;
+	}
+
+	// Check nodes only once the camera has travelled far enough to cross their threshold, as Planet does
+	Decisions RunQueue(const TestNodes& nodes, const std::vector<XMFLOAT3>& path, int* checks = nullptr)
+	{
+		Decisions decisions;
+		std::vector<bool> inside(nodes.Centres.size(), false);
+		NodeCheckQueue<uint32_t> queue;
+		for (uint32_t node = 0; node < nodes.Centres.size(); node++) queue.Push(node, 0);
+
+		double travel = 0;
+		int numChecks = 0;
+		std::vector<uint32_t> due;
+		for (int frame = 0; frame < int(path.size()); frame++)
+		{
+			if (frame > 0) travel += Distance(path[frame], path[frame - 1]);
+			queue.PopDue(travel, due);
+			for (auto node : due)
+			{
+				numChecks++;
+				float distance = Distance(path[frame], nodes.Centres[node]);
+				bool isInside = distance < nodes.Thresholds[node];
+				if (isInside != inside[node])
+				{
+					inside[node] = isInside;
+					decisions.push_back({ frame, node });
+				}
+				queue.Push(node, travel + std::abs(distance - nodes.Thresholds[node]));
+			}
+		}
+		if (checks) *checks = numChecks;
+		return decisions;
+	}
+}
+
+TEST(NodeCheckQueueReplacesChecks)
+{
+	NodeCheckQueue<uint32_t> queue;
+	queue.Push(3, 1.0);
+	queue.Push(5, 2.0);
+	queue.Push(3, 4.0);
+
+	// Nothing is due before the camera moves
+	std::vector<uint32_t> due;
+	queue.PopDue(0.5, due);
+	CHECK(due.empty());
+
+	// The first check of node 3 was replaced, so only node 5 is due
+	queue.PopDue(3.0, due);
+	CHECK(due.size() == 1 && due[0] == 5);
+	queue.PopDue(4.0, due);
+	CHECK(due.size() == 1 && due[0] == 3);
+	queue.PopDue(100.0, due);
+	CHECK(due.empty());
+
+	// A check queued at the current travel waits for the next call
+	queue.Push(7, 100.0);
+	queue.PopDue(100.0, due);
+	CHECK(due.size() == 1 && due[0] == 7);
+}
+
+TEST(NodeCheckQueueMatchesSweep)
+{
+	// Every change the full sweep finds is found by the queue in the same frame
+	auto nodes = MakeNodes(5000);
+	auto path = MakeCameraPath(500);
+	auto sweep = RunSweep(nodes, path);
+	auto queued = RunQueue(nodes, path);
+	CHECK(!sweep.empty());
+	CHECK(sweep.size() == queued.size());
+
+	std::sort(sweep.begin(), sweep.end());
+	std::sort(queued.begin(), queued.end());
+	std::vector<std::pair<int, uint32_t>> missed;
+	std::set_difference(sweep.begin(), sweep.end(), queued.begin(), queued.end(), std::back_inserter(missed));
+	if (!missed.empty()) std::printf("  %d of %d changes missed\n", int(missed.size()), int(sweep.size()));
+	CHECK(missed.empty());
+}
+
+TEST(NodeCheckQueueBenchmark)
+{
+	// A few seconds of flight at 60 frames per second
+	auto nodes = MakeNodes(50000);
+	auto path = MakeCameraPath(2000);
+	int checks = 0;
+	auto sweepTime = TimeMilliseconds([&] { RunSweep(nodes, path); }, 3);
+	auto queueTime = TimeMilliseconds([&] { RunQueue(nodes, path, &checks); }, 3);
+	std::printf("  %d nodes over %d frames: sweep %.3f ms, queue %.3f ms per frame with %.1f checks per node\n",
+		int(nodes.Centres.size()), int(path.size()), sweepTime / path.size(), queueTime / path.size(), double(checks) / nodes.Centres.size());
+}
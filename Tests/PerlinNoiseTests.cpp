@@ -0,0 +1,118 @@
+#include "Test.h"
+#include "PerlinNoise.h"
+#include "Utility.h"
+
+namespace
+{
+	// Positions on a grid over a patch of the noise input, as the planet scales its unit sphere by 200
+	struct SampleGrid
+	{
+		std::vector<float> X, Y, Z;
+	};
+
+	SampleGrid MakeGrid()
+	{
+		// Odd size so the SIMD paths leave positions for the scalar tail
+		const int size = 37;
+		SampleGrid grid;
+		for (int i = 0; i < size; i++)
+		{
+			for (int j = 0; j < size; j++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					grid.X.push_back(-200 + 400.0f * i / size);
+					grid.Y.push_back(-200 + 400.0f * j / size);
+					grid.Z.push_back(-150 + 137.3f * k + 0.37f * i);
+				}
+			}
+		}
+		return grid;
+	}
+
+	// Noise values and gradients from one instruction set
+	struct NoiseResults
+	{
+		std::vector<float> Value, Batch, GradientX, GradientY, GradientZ;
+	};
+
+	NoiseResults SampleNoise(NoiseInstructionSet instructionSet, const SampleGrid& grid, int octaves, float frequency, int firstOctave)
+	{
+		SetNoiseInstructionSetLimit(instructionSet);
+		auto count = grid.X.size();
+		NoiseResults results;
+		results.Value.resize(count);
+		results.Batch.resize(count);
+		results.GradientX.resize(count);
+		results.GradientY.resize(count);
+		results.GradientZ.resize(count);
+		FractalBrownianMotionBatch(1337, grid.X.data(), grid.Y.data(), grid.Z.data(), results.Batch.data(), count, octaves, frequency, firstOctave);
+		FractalBrownianMotionGradientBatch(1337, grid.X.data(), grid.Y.data(), grid.Z.data(), results.Value.data(),
+			results.GradientX.data(), results.GradientY.data(), results.GradientZ.data(), count, octaves, frequency, firstOctave);
+		SetNoiseInstructionSetLimit(NOISE_AVX2);
+		return results;
+	}
+
+	float MaxDifference(const std::vector<float>& a, const std::vector<float>& b)
+	{
+		float difference = 0;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			if (std::abs(a[i] - b[i]) > difference) difference = std::abs(a[i] - b[i]);
+		}
+		return difference;
+	}
+
+	float MaxMagnitude(const std::vector<float>& a)
+	{
+		float magnitude = 0;
+		for (auto value : a) if (std::abs(value) > magnitude) magnitude = std::abs(value);
+		return magnitude;
+	}
+}
+
+TEST(PerlinNoiseInstructionSetsMatch)
+{
+	// Each SIMD path gives the scalar result to within float rounding
+	auto grid = MakeGrid();
+	const struct { int Octaves; float Frequency; int FirstOctave; } settings[] = { { 8, 0.5f, 0 }, { 20, 1.0f, 0 }, { 12, 0.1f, 5 } };
+	for (auto& setting : settings)
+	{
+		auto scalar = SampleNoise(NOISE_SCALAR, grid, setting.Octaves, setting.Frequency, setting.FirstOctave);
+		float gradientScale = MaxMagnitude(scalar.GradientX) + MaxMagnitude(scalar.GradientY) + MaxMagnitude(scalar.GradientZ);
+		CHECK(MaxDifference(scalar.Value, scalar.Batch) <= 1e-6f);
+
+		for (auto instructionSet : { NOISE_SSE2, NOISE_AVX2 })
+		{
+			SetNoiseInstructionSetLimit(instructionSet);
+			if (GetNoiseInstructionSet() != instructionSet)
+			{
+				std::printf("  Instruction set %d not supported, skipped\n", int(instructionSet));
+				continue;
+			}
+			auto simd = SampleNoise(instructionSet, grid, setting.Octaves, setting.Frequency, setting.FirstOctave);
+			CHECK(MaxDifference(scalar.Batch, simd.Batch) <= 1e-5f);
+			CHECK(MaxDifference(scalar.Value, simd.Value) <= 1e-5f);
+			CHECK(MaxDifference(scalar.GradientX, simd.GradientX) <= 1e-5f * gradientScale);
+			CHECK(MaxDifference(scalar.GradientY, simd.GradientY) <= 1e-5f * gradientScale);
+			CHECK(MaxDifference(scalar.GradientZ, simd.GradientZ) <= 1e-5f * gradientScale);
+		}
+	}
+	SetNoiseInstructionSetLimit(NOISE_AVX2);
+}
+
+TEST(PerlinNoiseMatchesFastNoiseLite)
+{
+	// The scalar path gives FastNoiseLite's fractal sum
+	auto grid = MakeGrid();
+	auto scalar = SampleNoise(NOISE_SCALAR, grid, 8, 0.5f, 0);
+	FastNoiseLite noise(1337);
+	noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
+	float difference = 0;
+	for (size_t i = 0; i < grid.X.size(); i++)
+	{
+		auto reference = FractalBrownianMotion(&noise, { grid.X[i], grid.Y[i], grid.Z[i] }, 8, 0.5f);
+		if (std::abs(reference - scalar.Batch[i]) > difference) difference = std::abs(reference - scalar.Batch[i]);
+	}
+	CHECK(difference <= 1e-5f);
+}
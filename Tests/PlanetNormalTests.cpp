@@ -0,0 +1,124 @@
+#include "Test.h"
+#include "PerlinNoise.h"
+#include "PlanetSurface.h"
+
+#include <random>
+
+namespace
+{
+	const int SEED = 1337;
+	const int OCTAVES = 8;
+	const float FREQUENCY = 0.5f;
+
+	// Random directions on the unit sphere, as vertex directions are
+	std::vector<XMFLOAT3> MakeDirections(size_t count)
+	{
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> unit(-1, 1);
+		std::vector<XMFLOAT3> directions;
+		while (directions.size() < count)
+		{
+			XMFLOAT3 direction = { unit(random), unit(random), unit(random) };
+			if (DotProduct(direction, direction) < 0.01f) continue;
+			Normalize(&direction);
+			directions.push_back(direction);
+		}
+		return directions;
+	}
+
+	// Normals from the noise gradient, one gradient sample per vertex, as chunks and Planet light them
+	void AnalyticNormals(const std::vector<XMFLOAT3>& directions, std::vector<XMFLOAT3>& normals)
+	{
+		auto count = directions.size();
+		std::vector<float> x(count), y(count), z(count), elevation(count), gradientX(count), gradientY(count), gradientZ(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			x[i] = directions[i].x * 200;
+			y[i] = directions[i].y * 200;
+			z[i] = directions[i].z * 200;
+		}
+		FractalBrownianMotionGradientBatch(SEED, x.data(), y.data(), z.data(), elevation.data(),
+			gradientX.data(), gradientY.data(), gradientZ.data(), count, OCTAVES, FREQUENCY);
+
+		auto scale = PlanetSurface::MAX_ELEVATION * 200;
+		for (size_t i = 0; i < count; i++)
+		{
+			normals[i] = DisplacedSphereNormal(directions[i], elevation[i] * PlanetSurface::MAX_ELEVATION,
+				{ gradientX[i] * scale, gradientY[i] * scale, gradientZ[i] * scale });
+		}
+	}
+
+	// Normals from the surface sampled at each vertex and a small step along two tangents
+	void FiniteDifferenceNormals(const std::vector<XMFLOAT3>& directions, std::vector<XMFLOAT3>& normals, float step)
+	{
+		auto count = directions.size();
+		std::vector<XMFLOAT3> samples(count * 3);
+		std::vector<float> x(count * 3), y(count * 3), z(count * 3), elevation(count * 3);
+		for (size_t i = 0; i < count; i++)
+		{
+			// Tangents from any axis not along the direction
+			auto& direction = directions[i];
+			XMFLOAT3 axis = std::abs(direction.y) < 0.9f ? XMFLOAT3{ 0,1,0 } : XMFLOAT3{ 1,0,0 };
+			auto tangent = CrossProduct(axis, direction);
+			Normalize(&tangent);
+			auto bitangent = CrossProduct(direction, tangent);
+
+			samples[i * 3] = direction;
+			samples[i * 3 + 1] = AddFloat3(direction, MulFloat3(tangent, { step, step, step })).Pos;
+			samples[i * 3 + 2] = AddFloat3(direction, MulFloat3(bitangent, { step, step, step })).Pos;
+			for (int j = 0; j < 3; j++)
+			{
+				auto& sample = samples[i * 3 + j];
+				Normalize(&sample);
+				x[i * 3 + j] = sample.x * 200;
+				y[i * 3 + j] = sample.y * 200;
+				z[i * 3 + j] = sample.z * 200;
+			}
+		}
+		FractalBrownianMotionBatch(SEED, x.data(), y.data(), z.data(), elevation.data(), count * 3, OCTAVES, FREQUENCY);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			XMFLOAT3 points[3];
+			for (int j = 0; j < 3; j++)
+			{
+				auto scale = 1 + elevation[i * 3 + j] * PlanetSurface::MAX_ELEVATION;
+				points[j] = MulFloat3(samples[i * 3 + j], { scale, scale, scale });
+			}
+			normals[i] = CrossProduct(SubFloat3(points[1], points[0]), SubFloat3(points[2], points[0]));
+			Normalize(&normals[i]);
+		}
+	}
+}
+
+TEST(PlanetNormalsMatchFiniteDifference)
+{
+	// The analytic normal points the way the surface faces
+	auto directions = MakeDirections(4096);
+	std::vector<XMFLOAT3> analytic(directions.size()), difference(directions.size());
+	AnalyticNormals(directions, analytic);
+	FiniteDifferenceNormals(directions, difference, 1e-4f);
+
+	double total = 0;
+	int outward = 0;
+	for (size_t i = 0; i < directions.size(); i++)
+	{
+		auto cosine = DotProduct(analytic[i], difference[i]);
+		total += std::acos(cosine < 1 ? cosine : 1);
+		if (DotProduct(analytic[i], directions[i]) > 0) outward++;
+	}
+	auto meanDegrees = total / directions.size() * 180 / 3.14159265;
+	CHECK(meanDegrees < 1.0);
+	CHECK(outward == int(directions.size()));
+}
+
+TEST(PlanetNormalsBenchmark)
+{
+	// Cost per vertex of a gradient sample against three value samples
+	auto directions = MakeDirections(65536);
+	std::vector<XMFLOAT3> normals(directions.size());
+	auto analyticTime = TimeMilliseconds([&] { AnalyticNormals(directions, normals); });
+	auto differenceTime = TimeMilliseconds([&] { FiniteDifferenceNormals(directions, normals, 1e-4f); });
+	std::printf("  %d vertices, %d octaves: analytic %.1f ms, finite difference %.1f ms\n",
+		int(directions.size()), OCTAVES, analyticTime, differenceTime);
+}
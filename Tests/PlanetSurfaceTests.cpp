@@ -0,0 +1,431 @@
+#include "Test.h"
+#include "PlanetSurface.h"
+
+#include <cfloat>
+#include <random>
+
+namespace
+{
+	// Triangle of the quadtree by the directions of its corners
+	struct TestNode
+	{
+		XMFLOAT3 Corners[3];
+		int Level;
+		int Parent = -1;
+	};
+
+	// Base icosahedron the planet starts from
+	std::vector<TestNode> GetBaseNodes()
+	{
+		const float X = 0.525731112119133606f;
+		const float Z = 0.850650808352039932f;
+		const float N = 0.0f;
+		XMFLOAT3 vertices[] =
+		{
+			{-X,N,Z}, {X,N,Z}, {-X,N,-Z}, {X,N,-Z}, {N,Z,X}, {N,Z,-X},
+			{N,-Z,X}, {N,-Z,-X}, {Z,X,N}, {-Z,X,N}, {Z,-X,N}, {-Z,-X,N}
+		};
+		int indices[] =
+		{
+			1,4,0,	4,9,0,	4,5,9,	8,5,4,	1,8,4,	1,10,8,	10,3,8, 8,3,5,	3,2,5,	3,7,2,
+			3,10,7,	10,6,7,	6,11,7,	6,0,11,	6,1,0,	10,1,6,	11,0,9,	2,11,9,	5,2,9,	11,2,7
+		};
+		std::vector<TestNode> nodes;
+		for (int i = 0; i < 60; i += 3)
+		{
+			nodes.push_back({ { vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]] }, 0 });
+		}
+		return nodes;
+	}
+
+	// Split a node into four at its edge midpoints, as Planet::SubdivideTriangle does
+	std::vector<TestNode> Subdivide(const TestNode& node)
+	{
+		XMFLOAT3 a = Midpoint(node.Corners[0], node.Corners[1]);
+		XMFLOAT3 b = Midpoint(node.Corners[1], node.Corners[2]);
+		XMFLOAT3 c = Midpoint(node.Corners[2], node.Corners[0]);
+		Normalize(&a);
+		Normalize(&b);
+		Normalize(&c);
+		int level = node.Level + 1;
+		return
+		{
+			{ { node.Corners[0], a, c }, level },
+			{ { node.Corners[1], b, a }, level },
+			{ { node.Corners[2], c, b }, level },
+			{ { a, b, c }, level }
+		};
+	}
+
+	// Bound a node with its corners displaced by the octaves its level shows
+	NodeBounds BoundNode(const PlanetSurface& surface, const TestNode& node)
+	{
+		auto octaves = surface.GetOctavesForLevel(node.Level);
+		return surface.BoundTriangle(surface.GetPoint(node.Corners[0], octaves), surface.GetPoint(node.Corners[1], octaves),
+			surface.GetPoint(node.Corners[2], octaves), node.Level);
+	}
+
+	// Add a node's four children to the tree, returns the index of the first
+	int AddChildren(std::vector<TestNode>& nodes, int parent)
+	{
+		int first = int(nodes.size());
+		for (auto& child : Subdivide(nodes[parent]))
+		{
+			child.Parent = parent;
+			nodes.push_back(child);
+		}
+		return first;
+	}
+
+	// Tree of every node down to a level, split further along random paths to the last level.
+	// Children always come after their parent
+	std::vector<TestNode> GetTestNodes(int fullLevels, int maxLOD, int paths, unsigned seed)
+	{
+		std::vector<TestNode> nodes = GetBaseNodes();
+		int levelStart = 0;
+		for (int level = 0; level < fullLevels && level < maxLOD; level++)
+		{
+			int levelEnd = int(nodes.size());
+			for (int i = levelStart; i < levelEnd; i++) AddChildren(nodes, i);
+			levelStart = levelEnd;
+		}
+
+		std::mt19937 random(seed);
+		int deepest = int(nodes.size());
+		for (int path = 0; path < paths; path++)
+		{
+			int node = levelStart + random() % (deepest - levelStart);
+			while (nodes[node].Level < maxLOD)
+			{
+				node = AddChildren(nodes, node) + random() % NODE_CHILDREN;
+			}
+		}
+		return nodes;
+	}
+
+	// Bound every node of a tree, with each node's bounds grown to hold its children's as Planet does
+	std::vector<NodeBounds> BoundTree(const PlanetSurface& surface, const std::vector<TestNode>& nodes)
+	{
+		std::vector<NodeBounds> bounds;
+		for (auto& node : nodes) bounds.push_back(BoundNode(surface, node));
+		for (int i = int(nodes.size()) - 1; i >= 0; i--)
+		{
+			if (nodes[i].Parent >= 0) EncloseBounds(bounds[nodes[i].Parent], bounds[i]);
+		}
+		return bounds;
+	}
+
+	// Directions on a grid across a node's triangle, corners included
+	std::vector<XMFLOAT3> GetSampleDirections(const TestNode& node, int divisions)
+	{
+		std::vector<XMFLOAT3> directions;
+		for (int i = 0; i <= divisions; i++)
+		{
+			for (int j = 0; i + j <= divisions; j++)
+			{
+				float u = float(i) / divisions;
+				float v = float(j) / divisions;
+				float w = 1 - u - v;
+				XMFLOAT3 direction =
+				{
+					node.Corners[0].x * u + node.Corners[1].x * v + node.Corners[2].x * w,
+					node.Corners[0].y * u + node.Corners[1].y * v + node.Corners[2].y * w,
+					node.Corners[0].z * u + node.Corners[1].z * v + node.Corners[2].z * w
+				};
+				Normalize(&direction);
+				directions.push_back(direction);
+			}
+		}
+		return directions;
+	}
+
+	// Octave counts the surface over a node is drawn with at its level and below, ending with every octave
+	std::vector<int> GetDrawnOctaves(const PlanetSurface& surface, int level)
+	{
+		std::vector<int> octaves;
+		for (; level <= surface.mMaxLOD; level++)
+		{
+			auto count = surface.GetOctavesForLevel(level);
+			if (octaves.empty() || octaves.back() != count) octaves.push_back(count);
+		}
+		return octaves;
+	}
+
+	PlanetSurface MakeSurface(float frequency, int octaves, int maxLOD, int seed)
+	{
+		PlanetSurface surface;
+		surface.mFrequency = frequency;
+		surface.mOctaves = octaves;
+		surface.mMaxLOD = maxLOD;
+		surface.mSeed = seed;
+		return surface;
+	}
+
+	// Camera looking from a position at a target, with the planet's projection
+	struct TestCamera
+	{
+		XMFLOAT3 Position;
+		XMFLOAT3 Target;
+	};
+
+	Frustum GetCameraFrustum(const TestCamera& camera)
+	{
+		XMVECTOR position = XMVectorSet(camera.Position.x, camera.Position.y, camera.Position.z, 1);
+		XMVECTOR target = XMVectorSet(camera.Target.x, camera.Target.y, camera.Target.z, 1);
+		XMVECTOR up = XMVectorSet(0, 1, 0, 0);
+		if (std::abs(camera.Position.x) < 1e-4f && std::abs(camera.Position.z) < 1e-4f) up = XMVectorSet(0, 0, 1, 0);
+		XMFLOAT4X4 viewProj;
+		XMStoreFloat4x4(&viewProj, XMMatrixMultiply(XMMatrixLookAtLH(position, target, up),
+			XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 0.001f, 1000.0f)));
+		return Frustum(viewProj);
+	}
+
+	// Is a point in line of sight of the camera, ignoring the terrain but not the sphere under it
+	bool IsPointInSight(XMFLOAT3 camera, float occluderRadius, XMFLOAT3 point)
+	{
+		// Closest point to the planet centre on the line of sight
+		auto ray = SubFloat3(point, camera);
+		float t = -DotProduct(camera, ray) / DotProduct(ray, ray);
+		t = t < 0 ? 0 : (t > 1 ? 1 : t);
+		auto closest = AddFloat3(camera, MulFloat3(ray, { t, t, t })).Pos;
+		return Distance(closest, XMFLOAT3{ 0,0,0 }) >= occluderRadius;
+	}
+
+	// Can the camera see a point
+	bool IsPointVisible(const Frustum& frustum, XMFLOAT3 camera, float occluderRadius, XMFLOAT3 point)
+	{
+		return frustum.IntersectsSphere(point, 0) && IsPointInSight(camera, occluderRadius, point);
+	}
+
+	// Sample octaves that cover the planet's sliders from smooth to the full range
+	const struct { float Frequency; int Octaves; int MaxLOD; } SURFACE_SETTINGS[] =
+	{
+		{ 0.5f, 8, 6 },
+		{ 0.5f, 8, 10 },
+		{ 1.0f, 20, 10 },
+		{ 0.1f, 3, 8 },
+		{ 1.0f, 1, 10 },
+	};
+}
+
+TEST(PlanetSurfaceBoundsContainSurface)
+{
+	// The surface drawn over a node at its level and every level below stays inside its bounds
+	for (auto& settings : SURFACE_SETTINGS)
+	{
+		auto surface = MakeSurface(settings.Frequency, settings.Octaves, settings.MaxLOD, 1337);
+		int outsideRadius = 0, outsideMaxRadius = 0, samples = 0;
+		for (auto& node : GetTestNodes(3, surface.mMaxLOD, 100, 7))
+		{
+			auto bounds = BoundNode(surface, node);
+			auto drawnOctaves = GetDrawnOctaves(surface, node.Level);
+			for (auto& direction : GetSampleDirections(node, 10))
+			{
+				for (auto octaves : drawnOctaves)
+				{
+					auto point = surface.GetPoint(direction, octaves);
+					if (Distance(point, bounds.Centre) > bounds.Radius + 1e-5f) outsideRadius++;
+					if (Distance(point, XMFLOAT3{ 0,0,0 }) > bounds.MaxRadius + 1e-5f) outsideMaxRadius++;
+					samples++;
+				}
+			}
+		}
+		if (outsideRadius || outsideMaxRadius)
+		{
+			std::printf("  Frequency %.1f, %d octaves, LOD %d: %d of %d samples outside the radius, %d outside the max radius\n",
+				settings.Frequency, settings.Octaves, settings.MaxLOD, outsideRadius, samples, outsideMaxRadius);
+		}
+		CHECK(outsideRadius == 0);
+		CHECK(outsideMaxRadius == 0);
+	}
+}
+
+TEST(PlanetSurfaceMaxRadiusWithinElevation)
+{
+	auto surface = MakeSurface(1.0f, 20, 10, 99);
+	for (auto& node : GetTestNodes(2, surface.mMaxLOD, 20, 3))
+	{
+		auto bounds = BoundNode(surface, node);
+		CHECK(bounds.MaxRadius <= 1 + PlanetSurface::MAX_ELEVATION);
+		CHECK(bounds.Error >= 0);
+	}
+}
+
+TEST(PlanetSurfaceBoundsNest)
+{
+	// After growing, every node's sphere holds its children's and reaches as far out
+	auto surface = MakeSurface(1.0f, 20, 10, 4);
+	auto nodes = GetTestNodes(3, surface.mMaxLOD, 50, 9);
+	auto bounds = BoundTree(surface, nodes);
+	int escaped = 0;
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		auto parent = nodes[i].Parent;
+		if (parent < 0) continue;
+		auto distance = Distance(bounds[i].Centre, bounds[parent].Centre);
+		if (distance + bounds[i].Radius > bounds[parent].Radius * 1.00001f) escaped++;
+		if (bounds[i].MaxRadius > bounds[parent].MaxRadius) escaped++;
+	}
+	CHECK(escaped == 0);
+
+	// A sphere outside grows the bounds to the smallest sphere holding both
+	NodeBounds outer = { 0, { 0,0,0 }, 1, 1 };
+	CHECK(EncloseBounds(outer, { 0, { 2,0,0 }, 0.5f, 1.2f }));
+	CHECK_NEAR(outer.Radius, 1.75f, 1e-5f);
+	CHECK_NEAR(outer.Centre.x, 0.75f, 1e-5f);
+	CHECK_NEAR(outer.MaxRadius, 1.2f, 1e-6f);
+	CHECK(!EncloseBounds(outer, { 0, { 1,0,0 }, 0.5f, 1.0f }));
+}
+
+TEST(PlanetSurfaceHorizon)
+{
+	// From far away a sphere on the far side is hidden, one on the near side is not
+	XMFLOAT3 camera = { 0, 0, -5 };
+	CHECK(IsBelowHorizon(camera, 0.7f, { 0, 0, 1 }, 0.05f, 1.0f));
+	CHECK(!IsBelowHorizon(camera, 0.7f, { 0, 0, -1 }, 0.05f, 1.0f));
+
+	// Mountains on the far side can show over the horizon
+	CHECK(!IsBelowHorizon(camera, 0.7f, { 0.9f, 0, 0.1f }, 0.05f, 1.3f));
+
+	// Nothing is hidden from inside the occluder
+	CHECK(!IsBelowHorizon({ 0, 0, 0.5f }, 0.7f, { 0, 0, -1 }, 0.05f, 1.0f));
+}
+
+TEST(PlanetSurfaceSyntheticCameras)
+{
+	// Any node with a visible point of the surface is never culled
+	auto surface = MakeSurface(0.5f, 8, 10, 2024);
+	float occluder = 1 - PlanetSurface::MAX_ELEVATION;
+	TestCamera cameras[] =
+	{
+		{ { 0, 0, -5 }, { 0, 0, 0 } },          // Orbit
+		{ { 3, 1, 2 }, { 0, 0, 0 } },           // Orbit off axis
+		{ { 0, 1.6f, -1.6f }, { 0, 0, 0 } },    // Close orbit
+		{ { 0, 1.35f, 0 }, { 1, 1.35f, 0 } },   // Above the highest peaks looking at the horizon
+		{ { 0, 1.1f, 0 }, { 1, 0.9f, 0.2f } },  // Among the mountains
+		{ { 0, 2.5f, 0 }, { 0, 0, 0 } },        // Straight down
+		{ { 0.8f, 0.8f, 0.6f }, { 0, 0, 0 } },  // Inside the terrain
+	};
+
+	auto nodes = GetTestNodes(4, surface.mMaxLOD, 200, 11);
+	auto bounds = BoundTree(surface, nodes);
+	int culledNodes = 0, inheritedNodes = 0;
+	for (auto& camera : cameras)
+	{
+		// Walk the tree from the base nodes, children take their parent's result as CullNodes does
+		auto frustum = GetCameraFrustum(camera);
+		std::vector<NodeVisibility> visibility(nodes.size());
+		int missed = 0;
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			auto parentVisibility = nodes[i].Parent >= 0 ? visibility[nodes[i].Parent] : NODE_VISIBLE;
+			if (parentVisibility != NODE_VISIBLE) inheritedNodes++;
+			visibility[i] = CheckSphereVisible(frustum, camera.Position, occluder, bounds[i].Centre, bounds[i].Radius,
+				bounds[i].MaxRadius, parentVisibility);
+			if (visibility[i] != NODE_CULLED) continue;
+			culledNodes++;
+
+			// Look for any surface point the camera could see
+			for (auto& direction : GetSampleDirections(nodes[i], 6))
+			{
+				if (IsPointVisible(frustum, camera.Position, occluder, surface.GetPoint(direction, surface.mOctaves)))
+				{
+					missed++;
+					break;
+				}
+			}
+		}
+		if (missed)
+		{
+			std::printf("  Camera at %.2f %.2f %.2f culled %d nodes with visible surface\n",
+				camera.Position.x, camera.Position.y, camera.Position.z, missed);
+		}
+		CHECK(missed == 0);
+	}
+
+	// The cameras cull something and pass results down, so the check above is not empty
+	CHECK(culledNodes > 0);
+	CHECK(inheritedNodes > 0);
+}
+
+TEST(PlanetSurfaceObjectsDescendingCamera)
+{
+	// Objects scattered on and above the surface, as models are placed
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> unit(-1, 1);
+	struct { XMFLOAT3 Centre; float Radius; } objects[300];
+	for (auto& object : objects)
+	{
+		XMFLOAT3 direction = { unit(random), unit(random), unit(random) };
+		Normalize(&direction);
+		float height = 1 + unit(random) * 0.3f;
+		object.Centre = MulFloat3(direction, { height, height, height });
+		object.Radius = 0.01f + (unit(random) + 1) * 0.05f;
+	}
+
+	// Camera coming down from orbit to just above the peaks
+	float occluder = 1 - PlanetSurface::MAX_ELEVATION;
+	XMFLOAT3 down = { 0.3f, 0.9f, -0.2f };
+	Normalize(&down);
+	int firstCulled = -1, lastCulled = 0;
+	for (float altitude = 6.0f; altitude >= 1.31f; altitude *= 0.9f)
+	{
+		auto camera = MulFloat3(down, { altitude, altitude, altitude });
+		int culled = 0, missed = 0;
+		for (auto& object : objects)
+		{
+			if (!IsObjectBelowHorizon(camera, occluder, object.Centre, object.Radius)) continue;
+			culled++;
+
+			// No point of a culled object can be in sight of the camera
+			for (int i = 0; i < 64; i++)
+			{
+				XMFLOAT3 offset = { unit(random), unit(random), unit(random) };
+				Normalize(&offset);
+				auto point = AddFloat3(object.Centre, MulFloat3(offset, { object.Radius, object.Radius, object.Radius })).Pos;
+				if (IsPointInSight(camera, occluder, point))
+				{
+					missed++;
+					break;
+				}
+			}
+		}
+		if (missed) std::printf("  Altitude %.2f culled %d objects in sight\n", altitude, missed);
+		CHECK(missed == 0);
+		if (firstCulled < 0) firstCulled = culled;
+		lastCulled = culled;
+	}
+
+	// More of the planet falls behind the horizon as the camera comes down
+	CHECK(firstCulled > 0);
+	CHECK(lastCulled > firstCulled);
+}
+
+TEST(PlanetSurfaceCameraAboveBaseCorner)
+{
+	// A camera just above a corner of a base node is far from the node's centre but inside its bounds,
+	// so the node has to split however coarse its error
+	auto surface = MakeSurface(0.5f, 8, 10, 2024);
+	auto node = GetBaseNodes()[0];
+	auto bounds = BoundNode(surface, node);
+	auto corner = surface.GetPoint(node.Corners[0], surface.GetOctavesForLevel(0));
+	auto camera = MulFloat3(corner, { 1.01f, 1.01f, 1.01f });
+	const float pixelsPerUnit = 935.0f; // 1080 lines with a 60 degree field of view
+
+	CHECK(Distance(camera, bounds.Centre) > bounds.Radius * 0.5f);
+	CHECK(NodeDistance(camera, bounds.Centre, bounds.Radius) == 0);
+	CHECK(ProjectNodeError(bounds.Error, NodeDistance(camera, bounds.Centre, bounds.Radius), pixelsPerUnit) == FLT_MAX);
+
+	// Moving away, the projected error is taken from the nearest point of the bounds, so it is never below
+	// that of the centre and falls as the camera leaves
+	float lastError = FLT_MAX;
+	for (float altitude = 0.1f; altitude < 100; altitude *= 2)
+	{
+		auto position = MulFloat3(corner, { 1 + altitude, 1 + altitude, 1 + altitude });
+		auto distance = NodeDistance(position, bounds.Centre, bounds.Radius);
+		auto error = ProjectNodeError(bounds.Error, distance, pixelsPerUnit);
+		CHECK(error >= ProjectNodeError(bounds.Error, Distance(position, bounds.Centre), pixelsPerUnit));
+		CHECK(error <= lastError);
+		lastError = error;
+	}
+}
@@ -0,0 +1,84 @@
+#include "Test.h"
+#include "PlanetVertex.h"
+
+#include <random>
+
+namespace
+{
+	// Angle in degrees between two vectors, in double as a float acos cannot resolve such small angles
+	double AngleDegrees(XMFLOAT3 a, XMFLOAT3 b)
+	{
+		double cx = double(a.y) * b.z - double(a.z) * b.y;
+		double cy = double(a.z) * b.x - double(a.x) * b.z;
+		double cz = double(a.x) * b.y - double(a.y) * b.x;
+		double dot = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z;
+		return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot) * 180.0 / 3.14159265358979;
+	}
+
+	// Rounding to two 16 bit octahedral coordinates stays under this, the worst seen is about 0.004 degrees
+	const float MAX_NORMAL_ERROR_DEGREES = 0.005f;
+}
+
+TEST(PlanetVertexRoundTrip)
+{
+	// Positions are kept exactly and the normal to within the packing error
+	Vertex vertex;
+	vertex.Pos = { 0.1234567f, -1.2345678f, 0.9876543f };
+	vertex.Normal = { 0.48f, -0.6f, 0.64f };
+	Normalize(&vertex.Normal);
+	vertex.UV = { 3, 4 };
+
+	auto unpacked = DecodePlanetVertex(EncodePlanetVertex(vertex));
+	CHECK(unpacked.Pos.x == vertex.Pos.x && unpacked.Pos.y == vertex.Pos.y && unpacked.Pos.z == vertex.Pos.z);
+	CHECK(AngleDegrees(unpacked.Normal, vertex.Normal) <= MAX_NORMAL_ERROR_DEGREES);
+	CHECK(unpacked.UV.x == 0 && unpacked.UV.y == 0);
+
+	// Packing again gives the same bits, so a reloaded chunk does not drift
+	auto packed = EncodePlanetVertex(vertex);
+	auto repacked = EncodePlanetVertex(DecodePlanetVertex(packed));
+	CHECK(packed.Normal[0] == repacked.Normal[0] && packed.Normal[1] == repacked.Normal[1]);
+}
+
+TEST(PlanetVertexOctahedralErrorBound)
+{
+	// Random normals over the sphere, both hemispheres
+	std::mt19937 random(21);
+	std::normal_distribution<float> gaussian;
+	double worst = 0;
+	for (int i = 0; i < 200000; i++)
+	{
+		XMFLOAT3 normal = { gaussian(random), gaussian(random), gaussian(random) };
+		Normalize(&normal);
+		std::int16_t packed[2];
+		EncodeOctahedralNormal(normal, packed);
+		auto decoded = DecodeOctahedralNormal(packed);
+		CHECK_NEAR(DotProduct(decoded, decoded), 1.0f, 1e-5f);
+		auto error = AngleDegrees(normal, decoded);
+		if (error > worst) worst = error;
+	}
+	std::printf("  Largest octahedral normal error %.5f degrees\n", worst);
+	CHECK(worst <= MAX_NORMAL_ERROR_DEGREES);
+}
+
+TEST(PlanetVertexOctahedralEdges)
+{
+	// Axes, the fold at the equator and the corners of the folded square
+	XMFLOAT3 normals[] =
+	{
+		{ 1,0,0 }, { -1,0,0 }, { 0,1,0 }, { 0,-1,0 }, { 0,0,1 }, { 0,0,-1 },
+		{ 0.7071068f, 0.7071068f, 0 }, { -0.7071068f, 0.7071068f, 0 }, { 0.6f, 0, -0.8f }, { 0, -0.6f, -0.8f },
+		{ 0.577f, -0.577f, -0.577f }, { -0.577f, -0.577f, -0.578f },
+	};
+	for (auto normal : normals)
+	{
+		Normalize(&normal);
+		std::int16_t packed[2];
+		EncodeOctahedralNormal(normal, packed);
+		CHECK(AngleDegrees(normal, DecodeOctahedralNormal(packed)) <= MAX_NORMAL_ERROR_DEGREES);
+	}
+
+	// A zero normal packs without dividing by zero
+	std::int16_t packed[2];
+	EncodeOctahedralNormal({ 0,0,0 }, packed);
+	CHECK(packed[0] == 0 && packed[1] == 0);
+}
@@ -0,0 +1,70 @@
+#include "Test.h"
+#include "../RetirementQueue.h"
+
+namespace
+{
+	// Counts its deletions so the test can see when the queue frees it
+	struct Tracked
+	{
+		Tracked(int& deleted) : mDeleted(deleted) {}
+		~Tracked() { mDeleted++; }
+		int& mDeleted;
+	};
+}
+
+TEST(RetirementQueueWaitsForFence)
+{
+	int deleted = 0;
+	RetirementQueue<Tracked> queue;
+
+	// Retired at fence 5, the GPU has only reached 4
+	queue.Retire(new Tracked(deleted), 5);
+	CHECK(queue.Collect(4) == 0);
+	CHECK(deleted == 0);
+	CHECK(queue.Size() == 1);
+
+	// Deleted once the fence reaches 5
+	CHECK(queue.Collect(5) == 1);
+	CHECK(deleted == 1);
+	CHECK(queue.Size() == 0);
+}
+
+TEST(RetirementQueueClampsFenceValues)
+{
+	int deleted = 0;
+	RetirementQueue<Tracked> queue;
+
+	// A value lower than one already queued is raised to it, so an object is never freed early
+	queue.Retire(new Tracked(deleted), 10);
+	queue.Retire(new Tracked(deleted), 7);
+	CHECK(queue.Collect(7) == 0);
+	CHECK(queue.Collect(9) == 0);
+	CHECK(deleted == 0);
+	CHECK(queue.Collect(10) == 2);
+	CHECK(deleted == 2);
+}
+
+TEST(RetirementQueueSimulatedFrames)
+{
+	// Drive the queue like the frame loop with a simulated fence running two frames behind
+	int deleted = 0;
+	RetirementQueue<Tracked> queue;
+	const int framesInFlight = 2;
+	std::uint64_t currentFence = 0;
+	for (int frame = 0; frame < 20; frame++)
+	{
+		std::uint64_t completed = currentFence > framesInFlight ? currentFence - framesInFlight : 0;
+		queue.Collect(completed);
+
+		// Everything retired before the completed fence has gone, nothing after it has
+		CHECK(deleted == int(completed));
+
+		// One object retired per frame, in use by the commands covered by the next signal
+		queue.Retire(new Tracked(deleted), currentFence + 1);
+		currentFence++;
+	}
+
+	// Flush frees the rest, as when the GPU is idle
+	queue.Flush();
+	CHECK(deleted == 20);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Small test runner for the parts of the engine that need no window or device. Each TEST registers
+// itself with the runner, and a failed CHECK is reported and counted without stopping the test
+struct TestCase
+{
+	const char* Name;
+	void (*Run)();
+};
+
+std::vector<TestCase>& GetTestCases();
+extern int TestFailures;
+
+struct TestRegistration
+{
+	TestRegistration(const char* name, void (*run)()) { GetTestCases().push_back({ name, run }); }
+};
+
+#define TEST(name) \
+	static void name(); \
+	static TestRegistration name##Registration(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { if (!(condition)) { std::printf("  %s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition); TestFailures++; } } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+	do { double checkA = double(a), checkB = double(b); if (!(std::abs(checkA - checkB) <= double(tolerance))) { \
+		std::printf("  %s(%d): CHECK_NEAR(%s, %s) failed, %g against %g\n", __FILE__, __LINE__, #a, #b, checkA, checkB); TestFailures++; } } while (0)
+
+// Milliseconds a function takes, the best of a few runs
+template <typename F>
+double TimeMilliseconds(F&& function, int runs = 5)
+{
+	double best = 1e30;
+	for (int run = 0; run < runs; run++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		function();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		if (elapsed.count() < best) best = elapsed.count();
+	}
+	return best;
+}
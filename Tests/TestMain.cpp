@@ -0,0 +1,32 @@
+#include "Test.h"
+#include <cstring>
+
+int TestFailures = 0;
+
+std::vector<TestCase>& GetTestCases()
+{
+	static std::vector<TestCase> testCases;
+	return testCases;
+}
+
+// Run every test, or only those whose name contains the first argument
+int main(int argc, char* argv[])
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+
+	int run = 0;
+	int failed = 0;
+	for (auto& test : GetTestCases())
+	{
+		if (filter && !std::strstr(test.Name, filter)) continue;
+
+		std::printf("%s\n", test.Name);
+		int failuresBefore = TestFailures;
+		test.Run();
+		run++;
+		if (TestFailures != failuresBefore) failed++;
+	}
+
+	std::printf("%d tests run, %d failed\n", run, failed);
+	return failed ? 1 : 0;
+}
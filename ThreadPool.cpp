@@ -0,0 +1,122 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int numThreads)
+{
+	if (numThreads <= 0) numThreads = int(std::thread::hardware_concurrency()) - 1;
+	if (numThreads <= 0) numThreads = 1;
+
+	for (int i = 0; i < numThreads; i++)
+	{
+		mThreads.push_back(std::thread(&ThreadPool::WorkerThread, this));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		// Tell the workers to quit once the queue is empty
+		std::unique_lock<std::mutex> l(mLock);
+		mQuit = true;
+	}
+	mWorkReady.notify_all();
+
+	for (auto& thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::AddJob(std::function<void()> job)
+{
+	{
+		std::unique_lock<std::mutex> l(mLock);
+		mJobs.push(std::move(job));
+		mNumJobs++;
+	}
+
+	// Signal a worker to start work
+	mWorkReady.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> l(mLock);
+	mWorkDone.wait(l, [&]() { return mNumJobs == 0; });
+}
+
+void ThreadPool::RunTasks(int count, void (*function)(void*, int), void* context)
+{
+	if (count <= 0) return;
+	{
+		std::unique_lock<std::mutex> l(mLock);
+		mTaskFunction = function;
+		mTaskContext = context;
+		mTaskCount = count;
+		mNextTask = 0;
+		mTasksLeft = count;
+	}
+	mWorkReady.notify_all();
+
+	// Take tasks on this thread too, so the batch finishes even while the workers are busy with jobs
+	std::unique_lock<std::mutex> l(mLock);
+	while (mNextTask < mTaskCount)
+	{
+		int task = mNextTask++;
+		l.unlock();
+		RunTask(task);
+		l.lock();
+	}
+	mTasksDone.wait(l, [&]() { return mTasksLeft == 0; });
+	mTaskCount = 0;
+	mNextTask = 0;
+}
+
+void ThreadPool::RunTask(int task)
+{
+	mTaskFunction(mTaskContext, task);
+
+	bool finished;
+	{
+		std::unique_lock<std::mutex> l(mLock);
+		finished = --mTasksLeft == 0;
+	}
+	if (finished) mTasksDone.notify_all();
+}
+
+void ThreadPool::WorkerThread()
+{
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			// Wait for a task, a job or a quit signal
+			std::unique_lock<std::mutex> l(mLock);
+			mWorkReady.wait(l, [&]() { return mQuit || !mJobs.empty() || mNextTask < mTaskCount; });
+
+			// Tasks come first, as a thread is waiting on them
+			if (mNextTask < mTaskCount)
+			{
+				int task = mNextTask++;
+				l.unlock();
+				RunTask(task);
+				continue;
+			}
+			if (mJobs.empty()) return;
+
+			job = std::move(mJobs.front());
+			mJobs.pop();
+		}
+
+		// Run the job
+		job();
+
+		{
+			// Flag the job as complete
+			std::unique_lock<std::mutex> l(mLock);
+			mNumJobs--;
+		}
+
+		// Signal waiting threads
+		mWorkDone.notify_all();
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <queue>
+#include <vector>
+
+// Pool of worker threads that run queued jobs
+class ThreadPool
+{
+public:
+	// Start the workers, zero uses one less than the number of hardware threads
+	ThreadPool(int numThreads = 0);
+	~ThreadPool();
+
+	// Queue a job to run on a worker
+	void AddJob(std::function<void()> job);
+
+	// Wait until every queued job has finished
+	void Wait();
+
+	// Run task(i) for i in [0, count) on the workers and the calling thread, returning once all have finished.
+	// The task is called by reference through a function pointer, so unlike AddJob nothing is allocated.
+	// One batch runs at a time
+	template <typename F>
+	void ParallelFor(int count, F& task)
+	{
+		RunTasks(count, [](void* context, int index) { (*static_cast<F*>(context))(index); }, &task);
+	}
+
+	int NumThreads() { return int(mThreads.size()); }
+
+private:
+	// Worker thread loop
+	void WorkerThread();
+
+	// Run a batch of tasks, see ParallelFor
+	void RunTasks(int count, void (*function)(void*, int), void* context);
+
+	// Run one task of the batch, called without the lock held
+	void RunTask(int task);
+
+	std::vector<std::thread> mThreads;
+	std::queue<std::function<void()>> mJobs;
+
+	std::mutex mLock;
+	std::condition_variable mWorkReady;
+	std::condition_variable mWorkDone;
+
+	// Jobs queued or running
+	int mNumJobs = 0;
+	bool mQuit = false;
+
+	// Current batch of tasks, the next to hand out and the number not yet finished
+	void (*mTaskFunction)(void*, int) = nullptr;
+	void* mTaskContext = nullptr;
+	int mTaskCount = 0;
+	int mNextTask = 0;
+	int mTasksLeft = 0;
+	std::condition_variable mTasksDone;
+};
@@ -1,135 +1,141 @@
 #include "TriangleChunk.h"
+#include "Planet.h"
 
-TriangleChunk::TriangleChunk(Vertex v1, Vertex v2, Vertex v3, float frequency, int octaves, FastNoiseLite* noise, ID3D12GraphicsCommandList* commandList)
+TriangleChunk::TriangleChunk(Vertex v1, Vertex v2, Vertex v3, float frequency, int octaves, int seed, ChunkTemplate* chunkTemplate)
 {
-	mVertices.reserve(sizeof(Vertex) * pow(mMaxLOD, 2));
-	mIndices.reserve(sizeof(int) * pow(mMaxLOD, 2) * 3);
+	mCorners[0] = v1;
+	mCorners[1] = v2;
+	mCorners[2] = v3;
+	mFrequency = frequency;
+	mOctaves = octaves;
+	mSeed = seed;
+	mTemplate = chunkTemplate;
+}
 
-	// Subdivide with starting triangle
-	Subdivide(v1, v2, v3);
+void TriangleChunk::Build()
+{
+	std::vector<Vertex> vertices;
+	PlaceVertices(vertices);
 
-	// Apply noise to each vertex
-	ApplyNoise(frequency,octaves,noise,mVertices);
+	// Apply noise and normals to each vertex
+	ApplyNoise(mFrequency, mOctaves, mSeed, vertices);
 
-	// Calculate normals
-	auto normals = CalculateNormals(mVertices, mIndices);
-	for (int i = 0; i < mVertices.size(); i++)
+	// Pack for drawing and caching
+	mVertices.resize(vertices.size());
+	for (int i = 0; i < vertices.size(); i++)
 	{
-		mVertices[i].Normal = normals[i];
+		mVertices[i] = EncodePlanetVertex(vertices[i]);
 	}
 
-	// Create new mesh
-	mMesh = new Mesh();
-
-	// Calculate buffer data
-	mMesh->mVertices = mVertices;
-	mMesh->mIndices = mIndices;
-	mMesh->CalculateBufferData(D3DDevice.Get(), commandList);
+	mBuilt = true;
 }
 
-
-bool TriangleChunk::Subdivide(Vertex v1, Vertex v2, Vertex v3, int level)
+void TriangleChunk::Load(const PackedChunkVertex* packed)
 {
-	// Create initial triangle
-	Triangle initialTriangle = { 0, 1, 2 };
-	mVertices.push_back(v1);
-	mVertices.push_back(v2);
-	mVertices.push_back(v3);
-
-	// Add initial triangle to list
-	std::vector<Triangle> triangles;
-	triangles.reserve(sizeof(Triangle) * pow(mMaxLOD, 2));
-	triangles.push_back(initialTriangle);
-
-	// Subdivide triangles
-	for (int i = 0; i < mMaxLOD; i++)
-	{
-		std::vector<Triangle> newTriangles;
+	std::vector<Vertex> vertices;
+	PlaceVertices(vertices);
 
-		for (const auto& triangle : triangles)
+	// Corners are shared with the planet so keep their positions exact
+	mVertices.resize(vertices.size());
+	for (int i = 0; i < vertices.size(); i++)
+	{
+		auto& vertex = mVertices[i];
+		vertex.Pos = vertices[i].Pos;
+		if (i > 2)
 		{
-			std::vector<Triangle> subdividedTriangles = SubdivideTriangle(triangle);
-			newTriangles.insert(newTriangles.end(), subdividedTriangles.begin(), subdividedTriangles.end());
+			auto scale = 1 + ChunkDiskCache::DecodeHeight(packed[i]);
+			vertex.Pos.x *= scale;
+			vertex.Pos.y *= scale;
+			vertex.Pos.z *= scale;
 		}
-		triangles = newTriangles;
-	}
 
-	// Create final vertex and index lists
-	for (const auto& triangle : triangles)
-	{
-		mIndices.push_back(triangle.Point[0]);
-		mIndices.push_back(triangle.Point[1]);
-		mIndices.push_back(triangle.Point[2]);
+		// Saved normals are packed the same way as drawn ones
+		vertex.Normal[0] = packed[i].Normal[0];
+		vertex.Normal[1] = packed[i].Normal[1];
 	}
 
-	return true;
+	mBuilt = true;
 }
 
-int TriangleChunk::GetVertexForEdge(int v1, int v2)
+void TriangleChunk::PlaceVertices(std::vector<Vertex>& vertices)
 {
-	// Create pair to use as key in map and normalise edge direction to prevent duplication
-	std::pair<int, int> vertexPair(v1, v2);
-	if (vertexPair.first > vertexPair.second) { std::swap(vertexPair.first, vertexPair.second); }
-
-	// Either create or reuse vertices
-	auto in = mVertexMap.insert({ vertexPair, mVertices.size() });
-	if (in.second)
+	// Place template vertices from the corners
+	auto& barycentrics = mTemplate->mBarycentrics;
+	vertices.resize(barycentrics.size());
+	for (int i = 0; i < 3; i++)
 	{
-		auto& edge1 = mVertices[v2];
-		auto& edge2 = mVertices[v1];
-		auto newPoint = AddFloat3(edge1.Pos, edge2.Pos);
-		Normalize(&newPoint.Pos);
-
-		// Set colours
-		newPoint.Colour.x = std::lerp(edge1.Colour.x, edge2.Colour.x, 0.5);
-		newPoint.Colour.y = std::lerp(edge1.Colour.y, edge2.Colour.y, 0.5);
-		newPoint.Colour.z = std::lerp(edge1.Colour.z, edge2.Colour.z, 0.5);
-
-		// Add to vertex array
-		mVertices.push_back(newPoint);
+		vertices[i] = mCorners[i];
 	}
+	for (int i = 3; i < barycentrics.size(); i++)
+	{
+		float weights[3] = { barycentrics[i].x, barycentrics[i].y, barycentrics[i].z };
+		auto& vertex = vertices[i];
 
-	return in.first->second;
+		// Interpolate position and project onto the sphere
+		for (int corner = 0; corner < 3; corner++)
+		{
+			vertex.Pos.x += weights[corner] * mCorners[corner].Pos.x;
+			vertex.Pos.y += weights[corner] * mCorners[corner].Pos.y;
+			vertex.Pos.z += weights[corner] * mCorners[corner].Pos.z;
+
+			// Set colours
+			vertex.Colour.x += weights[corner] * mCorners[corner].Colour.x;
+			vertex.Colour.y += weights[corner] * mCorners[corner].Colour.y;
+			vertex.Colour.z += weights[corner] * mCorners[corner].Colour.z;
+		}
+		Normalize(&vertex.Pos);
+	}
 }
 
-std::vector<Triangle> TriangleChunk::SubdivideTriangle(Triangle triangle)
+void TriangleChunk::Upload(ID3D12GraphicsCommandList* commandList)
 {
-	std::vector<Triangle> newTriangles;
-	newTriangles.reserve(sizeof(Triangle) * 4);
-	// For each edge
-	std::uint32_t mid[3];
-	for (int i = 0; i < 3; i++)
-	{
-		mid[i] = GetVertexForEdge(triangle.Point[i], triangle.Point[(i + 1) % 3]);
-	}
-
-	// Add triangles to new array
-	newTriangles.push_back({ triangle.Point[0], mid[0], mid[2] });
-	newTriangles.push_back({ triangle.Point[1], mid[1], mid[0] });
-	newTriangles.push_back({ triangle.Point[2], mid[2], mid[1] });
-	newTriangles.push_back({ mid[0], mid[1], mid[2] });
+	// Create new mesh
+	mMesh = new Mesh();
 
-	return newTriangles;
+	// Calculate buffer data from the compact vertices, drawing with the template's index buffer
+	auto indexAddress = mTemplate->GetIndexBuffer(commandList);
+	mMesh->CalculateBufferData(D3DDevice.Get(), commandList, mVertices.data(), UINT(mVertices.size()), sizeof(PlanetVertex),
+		indexAddress, DXGI_FORMAT_R16_UINT, mTemplate->mGPUIndices.size());
 }
 
-void TriangleChunk::ApplyNoise(float frequency, int octaves, FastNoiseLite* noise, std::vector<Vertex>& vertices)
+void TriangleChunk::ApplyNoise(float frequency, int octaves, int seed, std::vector<Vertex>& vertices)
 {
-	int index = 0;
-	for (auto& vertex : vertices)
+	// Dont apply noise to first triangles
+	const int first = 3;
+	if (vertices.size() <= first) return;
+	auto count = vertices.size() - first;
+
+	// Gather sample positions into separate arrays for the batch
+	std::vector<float> x(count), y(count), z(count), elevation(count);
+	std::vector<float> gradientX(count), gradientY(count), gradientZ(count);
+	for (size_t i = 0; i < count; i++)
 	{
-		// Dont apply noise to first triangles
-		if (index > 2)
-		{
-			auto position = MulFloat3(vertex.Pos, { 200,200,200 });
-			auto elevationValue = mSphereOffset + FractalBrownianMotion(noise, position, octaves, frequency);
+		auto position = MulFloat3(vertices[first + i].Pos, { 200,200,200 });
+		x[i] = position.x;
+		y[i] = position.y;
+		z[i] = position.z;
+	}
+	FractalBrownianMotionGradientBatch(seed, x.data(), y.data(), z.data(), elevation.data(),
+		gradientX.data(), gradientY.data(), gradientZ.data(), count, octaves, frequency);
 
-			elevationValue *= 0.3;
+	for (size_t i = 0; i < count; i++)
+	{
+		auto& vertex = vertices[first + i];
+		auto elevationValue = mSphereOffset + elevation[i];
 
-			auto Radius = Distance(vertex.Pos, XMFLOAT3{ 0,0,0 });
-			vertex.Pos.x *= 1 + (elevationValue / Radius);
-			vertex.Pos.y *= 1 + (elevationValue / Radius);
-			vertex.Pos.z *= 1 + (elevationValue / Radius);
-		}
-		index++;
+		elevationValue *= Planet::MAX_ELEVATION;
+
+		auto Radius = Distance(vertex.Pos, XMFLOAT3{ 0,0,0 });
+
+		// Normal from the slope of the noise, the same on both sides of a chunk border. The gradient is
+		// scaled like the elevation and by the 200 the position was scaled by
+		auto direction = MulFloat3(vertex.Pos, { 1 / Radius, 1 / Radius, 1 / Radius });
+		auto scale = Planet::MAX_ELEVATION * 200;
+		vertex.Normal = DisplacedSphereNormal(direction, elevationValue / Radius,
+			{ gradientX[i] * scale, gradientY[i] * scale, gradientZ[i] * scale });
+
+		vertex.Pos.x *= 1 + (elevationValue / Radius);
+		vertex.Pos.y *= 1 + (elevationValue / Radius);
+		vertex.Pos.z *= 1 + (elevationValue / Radius);
 	}
 }
\ No newline at end of file
@@ -1,40 +1,57 @@
 #pragma once
 
 #include "Utility.h"
-#include <map>
 #include <vector>
+#include <atomic>
 #include "Mesh.h"
 #include "FastNoiseLite.h"
 #include "Common.h"
+#include "ChunkTemplate.h"
+#include "ChunkCache.h"
+#include "ChunkDiskCache.h"
+#include "PerlinNoise.h"
+#include "PlanetVertex.h"
 
 class TriangleChunk
 {
 public:
-	TriangleChunk(Vertex v1, Vertex v2, Vertex v3, float frequency, int octaves, FastNoiseLite* noise, ID3D12GraphicsCommandList* commandList);
+	TriangleChunk(Vertex v1, Vertex v2, Vertex v3, float frequency, int octaves, int seed, ChunkTemplate* chunkTemplate);
 	~TriangleChunk() { delete mMesh; mMesh = nullptr; };
 
-	// Geometry
-	std::map<std::pair<int, int>, int> mVertexMap;
-	std::vector<Vertex> mVertices;
-	std::vector<uint32_t> mIndices;
+	// Build geometry, noise and normals. Safe to run on a worker thread
+	void Build();
 
-	Mesh* mMesh;
+	// Build geometry from heights and normals saved by the disk cache, without evaluating noise
+	void Load(const PackedChunkVertex* packed);
+
+	// Create GPU buffers for the built geometry on the main thread
+	void Upload(ID3D12GraphicsCommandList* commandList);
+
+	// Geometry in the compact planet layout, indices are shared through the template
+	std::vector<PlanetVertex> mVertices;
+
+	Mesh* mMesh = nullptr;
 	bool mCombine = false;
-private:
-	// Subdivide mesh
-	bool Subdivide(Vertex v1, Vertex v2, Vertex v3, int level = 0);
 
-	// Get vertex for triangle edge
-	int GetVertexForEdge(int v1, int v2);
+	// Key of the chunk's geometry in the chunk cache
+	ChunkKey mCacheKey;
 
-	// Subdivide triangle
-	std::vector<Triangle> SubdivideTriangle(Triangle triangle);
+	// Set by the worker when Build has finished
+	std::atomic<bool> mBuilt = false;
+private:
+	// Place template vertices on the sphere from the corners
+	void PlaceVertices(std::vector<Vertex>& vertices);
 
 	// Apply noise
-	void ApplyNoise(float frequency, int octaves, FastNoiseLite* noise, std::vector<Vertex>& vertices);
+	void ApplyNoise(float frequency, int octaves, int seed, std::vector<Vertex>& vertices);
 
-	int mMaxLOD = 6;
 	float mSphereOffset = 0.0;
 
+	// Build parameters
+	Vertex mCorners[3];
+	float mFrequency;
+	int mOctaves;
+	int mSeed;
+	ChunkTemplate* mTemplate;
 };
 
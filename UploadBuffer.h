@@ -3,51 +3,46 @@
 #include <wrl.h>
 #include <d3d12.h>
 #include "Utility.h"
+#include "MappedBuffer.h"
 
 using Microsoft::WRL::ComPtr;
 
+// Upload heap buffer kept mapped for its lifetime, written through MappedBuffer
 template <typename T>
-class UploadBuffer
+class UploadBuffer : public MappedBuffer<T>
 {
 public:
 	UploadBuffer(ID3D12Device* device, UINT elementCount, bool constant)
 	{
-		mElementSize = sizeof(T);
+		UINT elementSize = sizeof(T);
 		if (constant)
 		{
-			mElementSize = CalculateConstantBufferSize(sizeof(T));
+			elementSize = CalculateConstantBufferSize(sizeof(T));
 		}
 
 		if(FAILED(device->CreateCommittedResource(
 			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
 			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(mElementSize * elementCount),
+			&CD3DX12_RESOURCE_DESC::Buffer(elementSize * elementCount),
 			D3D12_RESOURCE_STATE_GENERIC_READ,
 			nullptr,
 			IID_PPV_ARGS(&mUploadBuffer))));
 
-		if (FAILED(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mData))))
+		BYTE* data = nullptr;
+		if (FAILED(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&data))))
 		{
 			MessageBox(0, L"Buffer map failed", L"Error", MB_OK);
 		}
-
+		this->SetMapping(data, elementCount, elementSize);
 	}
 
 	~UploadBuffer()
 	{
-		if (mUploadBuffer) { mUploadBuffer->Unmap(0, nullptr); mData = nullptr; }
-	}
-
-	void Copy(int element, const T& data)
-	{
-		memcpy(&mData[element * mElementSize], &data, sizeof(T));
+		if (mUploadBuffer) { mUploadBuffer->Unmap(0, nullptr); this->mData = nullptr; }
 	}
 
 	ID3D12Resource* GetBuffer() { return mUploadBuffer.Get(); }
 
 private:
 	ComPtr<ID3D12Resource> mUploadBuffer;
-	BYTE* mData = nullptr;
-	UINT mElementSize = 0;
 };
-
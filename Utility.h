@@ -10,6 +10,9 @@
 #include <assimp/scene.h>
 #include <vector>
 #include <array>
+#include <span>
+#include <algorithm>
+#include "ThreadPool.h"
 //#include "FrameResource.h"
 
 using namespace std;
@@ -32,6 +35,13 @@ struct Triangle
 	std::uint32_t Point[3];
 };
 
+// Range of bytes in a buffer
+struct ByteRange
+{
+	UINT Offset;
+	UINT Size;
+};
+
 // Light data
 const static int mMaxLights = 16;
 struct mLight
@@ -285,6 +295,19 @@ static XMFLOAT3 Center(XMFLOAT3 A, XMFLOAT3 B, XMFLOAT3 C)
 	return center;
 }
 
+// Normal of a unit sphere displaced along each direction by a height, from the height's gradient
+static XMFLOAT3 DisplacedSphereNormal(XMFLOAT3 direction, float height, XMFLOAT3 heightGradient)
+{
+	// Only the slope across the surface tilts the normal, so drop the part along the direction
+	auto along = DotProduct(heightGradient, direction);
+	XMFLOAT3 normal;
+	normal.x = direction.x * (1 + height) - (heightGradient.x - along * direction.x);
+	normal.y = direction.y * (1 + height) - (heightGradient.y - along * direction.y);
+	normal.z = direction.z * (1 + height) - (heightGradient.z - along * direction.z);
+	Normalize(&normal);
+	return normal;
+}
+
 // Fractal brownian motion noise function
 static float FractalBrownianMotion(FastNoiseLite* fastNoise, XMFLOAT3 fractalInput, float octaves, float frequency)
 {
@@ -304,94 +327,94 @@ static float FractalBrownianMotion(FastNoiseLite* fastNoise, XMFLOAT3 fractalInp
 	return result;
 }
 
-// Calculate normals on an array of vertices and indices
-static std::vector<XMFLOAT3> CalculateNormals(std::vector<Vertex> vertices, std::vector<uint32_t> indices)
+// Add the area weighted face normal of triangles [firstTriangle, lastTriangle) onto their vertices' normals
+static void AccumulateFaceNormals(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<XMFLOAT3> normals,
+	size_t firstTriangle, size_t lastTriangle)
 {
-	std::vector<XMFLOAT3> normals;
-
-	// Map of vertex to triangles in Triangles array
-	int numVerts = vertices.size();
-	std::vector<std::array<int32_t, 8>> VertToTriMap;
-	for (int i = 0; i < numVerts; i++)
+	for (size_t i = firstTriangle * 3; i < lastTriangle * 3; i += 3)
 	{
-		std::array<int32_t, 8> array{ -1,-1,-1,-1,-1,-1,-1,-1 };
-		VertToTriMap.push_back(array);
-	}
+		auto a = vertices[indices[i]].Pos;
+		auto b = vertices[indices[i + 1]].Pos;
+		auto c = vertices[indices[i + 2]].Pos;
 
-	// For each triangle for each vertex add triangle to vertex array entry
-	for (int i = 0; i < indices.size(); i++)
-	{
-		for (int j = 0; j < 8; j++)
+		// The unnormalised cross product is twice the triangle's area long, so large triangles count for more
+		auto normal = CrossProduct(SubFloat3(a, c), SubFloat3(b, c));
+		for (int j = 0; j < 3; j++)
 		{
-			if (VertToTriMap[indices[i]][j] < 0)
-			{
-				VertToTriMap[indices[i]][j] = i / 3;
-				break;
-			}
+			auto& vertexNormal = normals[indices[i + j]];
+			vertexNormal.x += normal.x;
+			vertexNormal.y += normal.y;
+			vertexNormal.z += normal.z;
 		}
 	}
+}
 
-	std::vector<XMFLOAT3> NTriangles;
-
-	for (int i = 0; i < indices.size() / 3; i++)
+// Normalise normals [first, last), leaving zero length normals of unused vertices at zero
+static void NormalizeNormals(std::span<XMFLOAT3> normals, size_t first, size_t last)
+{
+	for (size_t i = first; i < last; i++)
 	{
-		XMFLOAT3 normal = {};
-		NTriangles.push_back(normal);
+		auto& normal = normals[i];
+		auto length = std::sqrt(DotProduct(normal, normal));
+		if (length > 0)
+		{
+			normal.x /= length;
+			normal.y /= length;
+			normal.z /= length;
+		}
 	}
+}
 
-	int index = 0;
-	for (int i = 0; i < NTriangles.size(); i++)
-	{
-		NTriangles[i].x = indices[index];
-		NTriangles[i].y = indices[index + 1];
-		NTriangles[i].z = indices[index + 2];
-		index += 3;
-	}
+// Calculate smooth normals for vertices from an index list, writing one normal per vertex into normals
+static void CalculateNormals(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<XMFLOAT3> normals)
+{
+	std::fill(normals.begin(), normals.begin() + vertices.size(), XMFLOAT3{ 0,0,0 });
+	AccumulateFaceNormals(vertices, indices, normals, 0, indices.size() / 3);
+	NormalizeNormals(normals, 0, vertices.size());
+}
 
-	for (int i = 0; i < vertices.size(); i++)
+// As above, splitting the triangles between the pool's workers. Each triangle range sums into its own
+// vertices.size() long slice, the first into normals and the rest into scratch, so the number of ranges is
+// one more than the slices that fit. The slices are then added together and normalised over vertex ranges.
+// Nothing is allocated
+static void CalculateNormals(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<XMFLOAT3> normals,
+	std::span<XMFLOAT3> scratch, ThreadPool& pool)
+{
+	auto numVertices = vertices.size();
+	auto numTriangles = indices.size() / 3;
+	size_t numRanges = 1 + (numVertices > 0 ? scratch.size() / numVertices : 0);
+	if (numRanges > size_t(pool.NumThreads()) + 1) numRanges = pool.NumThreads() + 1;
+	if (numRanges <= 1)
 	{
-		normals.push_back({ 0,0,0 });
+		CalculateNormals(vertices, indices, normals);
+		return;
 	}
 
-	// For each vertex collect the triangles that share it and calculate the face normal
-	for (int i = 0; i < vertices.size(); i++)
+	// Scatter each triangle range into its own sum
+	auto accumulate = [&](int range)
 	{
-		for (auto& triangle : VertToTriMap[i])
+		auto sums = range == 0 ? normals.first(numVertices) : scratch.subspan((range - 1) * numVertices, numVertices);
+		std::fill(sums.begin(), sums.end(), XMFLOAT3{ 0,0,0 });
+		AccumulateFaceNormals(vertices, indices, sums, numTriangles * range / numRanges, numTriangles * (range + 1) / numRanges);
+	};
+	pool.ParallelFor(int(numRanges), accumulate);
+
+	// Gather the sums and normalise, each task owning a range of vertices
+	auto reduce = [&](int range)
+	{
+		auto first = numVertices * range / numRanges;
+		auto last = numVertices * (range + 1) / numRanges;
+		for (size_t slice = 1; slice < numRanges; slice++)
 		{
-			// This shouldnt happen
-			if (triangle < 0)
+			auto sums = scratch.subspan((slice - 1) * numVertices, numVertices);
+			for (size_t i = first; i < last; i++)
 			{
-				continue;
+				normals[i].x += sums[i].x;
+				normals[i].y += sums[i].y;
+				normals[i].z += sums[i].z;
 			}
-
-			// Get vertices from triangle index
-			auto A = vertices[NTriangles[triangle].x];
-			auto B = vertices[NTriangles[triangle].y];
-			auto C = vertices[NTriangles[triangle].z];
-
-			// Calculate edges
-			auto a = XMLoadFloat3(&A.Pos);
-			auto b = XMLoadFloat3(&B.Pos);
-			auto c = XMLoadFloat3(&C.Pos);
-
-			auto E1 = XMVectorSubtract(a, c);
-			auto E2 = XMVectorSubtract(b, c);
-
-			// Calculate normal with cross product and normalise
-			XMFLOAT3 Normal; XMStoreFloat3(&Normal, XMVector3Normalize(XMVector3Cross(E1, E2)));
-
-			normals[i].x += Normal.x;
-			normals[i].y += Normal.y;
-			normals[i].z += Normal.z;
 		}
-	}
-
-	// Average the face normals
-	for (auto& normal : normals)
-	{
-		XMFLOAT3 normalizedNormal;
-		XMStoreFloat3(&normalizedNormal, XMVector3Normalize(XMLoadFloat3(&normal)));
-		normal = normalizedNormal;
-	}
-	return normals;
+		NormalizeNormals(normals, first, last);
+	};
+	pool.ParallelFor(int(numRanges), reduce);
 }
\ No newline at end of file